@@ -0,0 +1,94 @@
+/**
+ * @file bench_get.c
+ * @brief Cost of a getter call, out of line and with HAY_FLAGS_INLINE.
+ *
+ * Built four times, against a static and a shared library, with and without
+ * HAY_FLAGS_INLINE. Each build reads a set of FT_INT, FT_BOOL and FT_STR
+ * flags in a loop, half of them unset, and prints one JSON object:
+ *
+ *   {"linkage":"shared","getters":"inline","gets":...,"ns_per_get":...}
+ *
+ * Usage: bench_get [--quick]
+ */
+
+#include <hay/flags.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef BENCH_SHARED
+#define BENCH_SHARED 0
+#endif
+
+#define BENCH_FLAGS 32
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+  bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+  long rounds = quick ? 100000 : 1000000;
+
+  static flag_t *ints[BENCH_FLAGS], *bools[BENCH_FLAGS], *strs[BENCH_FLAGS];
+  static flag_t *all[3 * BENCH_FLAGS + 1];
+  static char names[3 * BENCH_FLAGS][16];
+  static char *args[1 + 3 * BENCH_FLAGS];
+  int nargs = 0;
+  args[nargs++] = "bench";
+  for (int i = 0; i < BENCH_FLAGS; i++) {
+    snprintf(names[3 * i], sizeof(names[0]), "--int%d", i);
+    snprintf(names[3 * i + 1], sizeof(names[0]), "--bool%d", i);
+    snprintf(names[3 * i + 2], sizeof(names[0]), "--str%d", i);
+    ints[i] = all[3 * i] = hay_flags_create(names[3 * i] + 2, 0, FT_INT);
+    bools[i] = all[3 * i + 1] =
+        hay_flags_create(names[3 * i + 1] + 2, 0, FT_BOOL);
+    strs[i] = all[3 * i + 2] =
+        hay_flags_create(names[3 * i + 2] + 2, 0, FT_STR);
+    if (i % 2) { // Every other flag is left at its default.
+      continue;
+    }
+    args[nargs++] = names[3 * i];
+    args[nargs++] = "42";
+    args[nargs++] = names[3 * i + 1];
+    args[nargs++] = names[3 * i + 2];
+    args[nargs++] = "value";
+  }
+  flag_schema_t *schema = hay_flags_schema_create(all);
+  hay_flags_schema_parse(schema, nargs, args);
+
+  volatile long sink = 0;
+  uint64_t t0 = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    long sum = 0;
+    for (int i = 0; i < BENCH_FLAGS; i++) {
+      sum += hay_flags_getint(ints[i], 1);
+      sum += hay_flags_getbool(bools[i], false);
+      sum += hay_flags_getstr(strs[i], "")[0];
+    }
+    sink += sum;
+    // Keep the compiler from hoisting the loads out of the loop.
+    __asm__ volatile("" ::: "memory");
+  }
+  uint64_t ns = now_ns() - t0;
+  long gets = rounds * 3 * BENCH_FLAGS;
+
+#ifdef HAY_FLAGS_INLINE
+  const char *getters = "inline";
+#else
+  const char *getters = "call";
+#endif
+  printf("{\"linkage\":\"%s\",\"getters\":\"%s\",\"gets\":%ld,"
+         "\"ns_per_get\":%.3f}\n",
+         BENCH_SHARED ? "shared" : "static", getters, gets,
+         (double)ns / (double)gets);
+
+  hay_flags_schema_destroy(schema);
+  for (int i = 0; i < 3 * BENCH_FLAGS; i++) {
+    hay_flags_destroy(all[i]);
+  }
+  return 0;
+}
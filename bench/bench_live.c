@@ -0,0 +1,149 @@
+/**
+ * @file bench_live.c
+ * @brief Read throughput of hay_flags_live_*() against a mutex, under reload.
+ *
+ * Reader threads repeatedly read two flags, each pair from one consistent
+ * version, while a writer thread optionally applies a delta and publishes it
+ * at a fixed rate. Prints one JSON object per line:
+ *
+ *   {"impl":"live","threads":4,"reload_hz":1000,"reads":...,
+ *    "reads_per_sec":...,"ns_per_read":...}
+ *
+ * `reads` counts read sections (two getters each) over all threads, and
+ * `ns_per_read` is the wall time of one section on one thread. The "mutex"
+ * rows read the flags of the schema directly under a pthread mutex shared
+ * with the writer, the usual alternative.
+ *
+ * Usage: bench_live [--quick]
+ */
+
+#include <hay/flags.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef enum { IMPL_LIVE, IMPL_MUTEX } bench_impl_t;
+
+static const char *impl_names[] = {"live", "mutex"};
+
+static flag_t *port, *host;
+static flag_schema_t *schema;
+static flag_live_t *live;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_bool stop;
+static bench_impl_t impl;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void *bench_reader(void *arg) {
+  long *reads = arg;
+  long n = 0;
+  volatile long sink = 0;
+  flag_reader_t *r = impl == IMPL_LIVE ? hay_flags_live_reader(live) : nullptr;
+  while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+    for (int i = 0; i < 1024; i++) {
+      if (impl == IMPL_LIVE) {
+        hay_flags_live_enter(r);
+        sink += hay_flags_getint(hay_flags_live_get(r, port), 0);
+        sink += hay_flags_getstr(hay_flags_live_get(r, host), "")[0];
+        hay_flags_live_exit(r);
+      } else {
+        pthread_mutex_lock(&lock);
+        sink += hay_flags_getint(port, 0);
+        sink += hay_flags_getstr(host, "")[0];
+        pthread_mutex_unlock(&lock);
+      }
+    }
+    n += 1024;
+  }
+  hay_flags_live_reader_release(r);
+  *reads = n;
+  return nullptr;
+}
+
+static void bench_reload(int i) {
+  char p[16];
+  snprintf(p, sizeof(p), "%d", 1000 + i % 1000);
+  char *delta[] = {"--port", p, "--host", i % 2 ? "odd.example" : "even"};
+  if (impl == IMPL_LIVE) {
+    hay_flags_schema_apply(schema, 4, delta);
+    hay_flags_live_publish(live);
+  } else {
+    pthread_mutex_lock(&lock);
+    hay_flags_schema_apply(schema, 4, delta);
+    pthread_mutex_unlock(&lock);
+  }
+}
+
+static void bench_run(unsigned threads, unsigned reload_hz, uint64_t ns) {
+  pthread_t workers[64];
+  long reads[64] = {0};
+  atomic_store(&stop, false);
+  uint64_t t0 = now_ns();
+  for (unsigned t = 0; t < threads; t++) {
+    pthread_create(&workers[t], nullptr, bench_reader, &reads[t]);
+  }
+  int i = 0;
+  while (now_ns() - t0 < ns) {
+    if (reload_hz) {
+      bench_reload(i++);
+      usleep(1000000 / reload_hz);
+    } else {
+      usleep(1000);
+    }
+  }
+  atomic_store(&stop, true);
+  long total = 0;
+  for (unsigned t = 0; t < threads; t++) {
+    pthread_join(workers[t], nullptr);
+    total += reads[t];
+  }
+  double secs = (double)(now_ns() - t0) / 1e9;
+  printf("{\"impl\":\"%s\",\"threads\":%u,\"reload_hz\":%u,\"reads\":%ld,"
+         "\"reads_per_sec\":%.0f,\"ns_per_read\":%.2f}\n",
+         impl_names[impl], threads, reload_hz, total, (double)total / secs,
+         secs * 1e9 * threads / (double)total);
+  fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+  bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+  uint64_t ns = quick ? 50000000u : 500000000u;
+
+  port = hay_flags_create("port", 'p', FT_INT);
+  host = hay_flags_create("host", 'H', FT_STR);
+  flag_t *flags[] = {port, host, nullptr};
+  schema = hay_flags_schema_create(flags);
+  char *args[] = {"bench", "--port", "8080", "--host", "example"};
+  hay_flags_schema_parse(schema, 5, args);
+  live = hay_flags_live_create(schema);
+
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  unsigned max = cpus > 1 ? (unsigned)cpus - 1 : 1; // One CPU for the writer.
+  if (max > 64) {
+    max = 64;
+  }
+  static const unsigned rates[] = {0, 1000};
+  for (int m = IMPL_LIVE; m <= IMPL_MUTEX; m++) {
+    impl = (bench_impl_t)m;
+    for (size_t k = 0; k < sizeof(rates) / sizeof(rates[0]); k++) {
+      for (unsigned t = 1; t <= max; t *= 2) {
+        bench_run(t, rates[k], ns);
+      }
+    }
+  }
+
+  hay_flags_live_destroy(live);
+  hay_flags_schema_destroy(schema);
+  hay_flags_destroy(port);
+  hay_flags_destroy(host);
+  return 0;
+}
@@ -0,0 +1,327 @@
+/**
+ * @file bench_parse.c
+ * @brief Parse throughput and startup cost of hay/flags against getopt_long.
+ *
+ * Runs a matrix of flag counts, argument counts, flag styles (long, short,
+ * bundled shorts) and type mixes, and prints one JSON object per line:
+ *
+ *   {"impl":"hay","flags":100,"tokens":1000,"style":"long","mix":"int",
+ *    "create_ns":...,"freeze_ns":...,"ns_per_token":...,"get_ns":...,
+ *    "allocs_per_parse":...,"peak_rss_kb":...}
+ *
+ * `create_ns` and `freeze_ns` are the startup cost (hay_flags_create() for
+ * every flag, then hay_flags_schema_create()), `ns_per_token` the cost of one
+ * parse divided by the number of arguments, and `get_ns` the cost of one
+ * getter call. getopt_long rows leave the hay-specific columns at -1, and are
+ * skipped where its linear option scan would take minutes.
+ *
+ * Usage: bench_parse [--quick]
+ */
+
+#include <getopt.h>
+#include <hay/flags.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#if defined(__GLIBC__)
+// Count every allocation, including those libc makes on our behalf.
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+static size_t bench_allocs = 0;
+void *malloc(size_t size) {
+  bench_allocs++;
+  return __libc_malloc(size);
+}
+void *calloc(size_t n, size_t size) {
+  bench_allocs++;
+  return __libc_calloc(n, size);
+}
+void *realloc(void *ptr, size_t size) {
+  bench_allocs++;
+  return __libc_realloc(ptr, size);
+}
+#define BENCH_ALLOCS() ((long long)bench_allocs)
+#else
+#define BENCH_ALLOCS() (-1ll)
+#endif
+
+static const char shorts[] =
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+#define BENCH_SHORTS (sizeof(shorts) - 1)
+
+typedef enum { STYLE_LONG, STYLE_SHORT, STYLE_BUNDLED } bench_style_t;
+typedef enum { MIX_STR, MIX_INT, MIX_BOOL, MIX_MIXED } bench_mix_t;
+
+static const char *style_names[] = {"long", "short", "bundled"};
+static const char *mix_names[] = {"str", "int", "bool", "mixed"};
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static long peak_rss_kb(void) {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+}
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+static uint64_t rng(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state;
+}
+
+static flag_ty_t type_of(bench_mix_t mix, size_t i) {
+  switch (mix) {
+  case MIX_STR:
+    return FT_STR;
+  case MIX_INT:
+    return FT_INT;
+  case MIX_BOOL:
+    return FT_BOOL;
+  default:
+    return (flag_ty_t[]){FT_STR, FT_INT, FT_BOOL}[i % 3];
+  }
+}
+
+/**
+ * @brief The argument vector and names shared by both implementations.
+ */
+typedef struct bench_input {
+  size_t nflags;
+  bench_mix_t mix;
+  char **names;     ///< "f<i>"
+  char **longs;     ///< "--f<i>"
+  char **argv;      ///< Generated arguments, argv[0] is the program name.
+  int argc;
+  char *bundles;    ///< Storage for short and bundled tokens.
+} bench_input_t;
+
+static void input_build(bench_input_t *in, size_t nflags, size_t tokens,
+                        bench_style_t style, bench_mix_t mix) {
+  in->nflags = nflags;
+  in->mix = mix;
+  in->names = malloc(nflags * sizeof(char *));
+  in->longs = malloc(nflags * sizeof(char *));
+  for (size_t i = 0; i < nflags; i++) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "--f%zu", i);
+    in->longs[i] = strdup(buf);
+    in->names[i] = in->longs[i] + 2;
+  }
+
+  in->argv = malloc((tokens + 2) * sizeof(char *));
+  in->bundles = malloc(tokens * 8);
+  in->argv[0] = "bench";
+  size_t n = 0;
+  size_t nshort = nflags < BENCH_SHORTS ? nflags : BENCH_SHORTS;
+
+  while (n < tokens) {
+    size_t left = tokens - n;
+    char *tok;
+    size_t k;
+    if (style == STYLE_LONG) {
+      k = rng() % nflags;
+      tok = in->longs[k];
+    } else {
+      tok = in->bundles + n * 8;
+      size_t len = 1;
+      tok[0] = '-';
+      // Bundles hold up to three boolean shorts before the last flag.
+      size_t extra = style == STYLE_BUNDLED ? 3 : 0;
+      for (size_t b = 0; b < extra; b++) {
+        size_t j = rng() % nshort;
+        if (type_of(mix, j) == FT_BOOL) {
+          tok[len++] = shorts[j];
+        }
+      }
+      k = rng() % nshort;
+      tok[len++] = shorts[k];
+      tok[len] = '\0';
+    }
+
+    bool takes_value = type_of(mix, k) != FT_BOOL;
+    if (takes_value && left < 2) {
+      in->argv[1 + n++] = "operand";
+      continue;
+    }
+    in->argv[1 + n++] = tok;
+    if (takes_value) {
+      in->argv[1 + n++] = type_of(mix, k) == FT_INT ? "12345" : "value";
+    }
+  }
+  in->argv[1 + n] = nullptr;
+  in->argc = (int)n + 1;
+}
+
+static void input_free(bench_input_t *in) {
+  for (size_t i = 0; i < in->nflags; i++) {
+    free(in->longs[i]);
+  }
+  free(in->names);
+  free(in->longs);
+  free(in->argv);
+  free(in->bundles);
+}
+
+static size_t reps_for(size_t tokens) {
+  size_t reps = 2000000 / (tokens + 1);
+  return reps ? reps : 1;
+}
+
+static void bench_hay(const bench_input_t *in, bench_style_t style) {
+  uint64_t t0 = now_ns();
+  flag_t **flags = malloc((in->nflags + 1) * sizeof(flag_t *));
+  for (size_t i = 0; i < in->nflags; i++) {
+    char s = i < BENCH_SHORTS ? shorts[i] : 0;
+    flags[i] = hay_flags_create(in->names[i], s, type_of(in->mix, i));
+  }
+  flags[in->nflags] = nullptr;
+  uint64_t t1 = now_ns();
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  uint64_t t2 = now_ns();
+  hay_flags_schema_set_opts(schema, FSO_BORROW);
+
+  size_t reps = reps_for((size_t)in->argc);
+  hay_flags_schema_parse(schema, in->argc, in->argv); // Warm up.
+  long long a0 = BENCH_ALLOCS();
+  uint64_t t3 = now_ns();
+  for (size_t r = 0; r < reps; r++) {
+    hay_flags_schema_parse(schema, in->argc, in->argv);
+  }
+  uint64_t t4 = now_ns();
+  long long a1 = BENCH_ALLOCS();
+
+  volatile long sink = 0;
+  uint64_t t5 = now_ns();
+  for (size_t i = 0; i < in->nflags; i++) {
+    sink += hay_flags_getint(flags[i], 0) + hay_flags_getbool(flags[i], false) +
+            (hay_flags_getstr(flags[i], nullptr) != nullptr);
+  }
+  uint64_t t6 = now_ns();
+
+  printf("{\"impl\":\"hay\",\"flags\":%zu,\"tokens\":%d,\"style\":\"%s\","
+         "\"mix\":\"%s\",\"create_ns\":%llu,\"freeze_ns\":%llu,"
+         "\"ns_per_token\":%.2f,\"get_ns\":%.2f,\"allocs_per_parse\":%.2f,"
+         "\"peak_rss_kb\":%ld}\n",
+         in->nflags, in->argc - 1, style_names[style], mix_names[in->mix],
+         (unsigned long long)(t1 - t0), (unsigned long long)(t2 - t1),
+         (double)(t4 - t3) / (double)reps / (double)(in->argc - 1),
+         (double)(t6 - t5) / (double)(in->nflags * 3),
+         a0 < 0 ? -1.0 : (double)(a1 - a0) / (double)reps, peak_rss_kb());
+
+  hay_flags_schema_destroy(schema);
+  for (size_t i = 0; i < in->nflags; i++) {
+    hay_flags_destroy(flags[i]);
+  }
+  free(flags);
+}
+
+static void bench_getopt(const bench_input_t *in, bench_style_t style) {
+  struct option *opts = calloc(in->nflags + 1, sizeof(struct option));
+  char *optstring = malloc(BENCH_SHORTS * 2 + 2);
+  size_t o = 0;
+  optstring[o++] = ':';
+  for (size_t i = 0; i < in->nflags; i++) {
+    bool arg = type_of(in->mix, i) != FT_BOOL;
+    opts[i] = (struct option){in->names[i], arg ? required_argument
+                                                : no_argument,
+                              nullptr, (int)(256 + i)};
+    if (i < BENCH_SHORTS) {
+      optstring[o++] = shorts[i];
+      if (arg) {
+        optstring[o++] = ':';
+      }
+    }
+  }
+  optstring[o] = '\0';
+
+  const char **vals = calloc(in->nflags, sizeof(char *));
+  char **argv = malloc(((size_t)in->argc + 1) * sizeof(char *));
+  // Long options cost a scan of every option per argument.
+  size_t reps = reps_for((size_t)in->argc *
+                         (style == STYLE_LONG ? in->nflags / 10 + 1 : 1));
+
+  uint64_t t0 = now_ns();
+  for (size_t r = 0; r < reps; r++) {
+    // getopt_long permutes argv, so every run starts from a fresh copy.
+    memcpy(argv, in->argv, ((size_t)in->argc + 1) * sizeof(char *));
+#if defined(__GLIBC__)
+    optind = 0;
+#else
+    optind = 1;
+#endif
+    opterr = 0;
+    int c;
+    while ((c = getopt_long(in->argc, argv, optstring, opts, nullptr)) != -1) {
+      size_t idx;
+      if (c >= 256) {
+        idx = (size_t)c - 256;
+      } else {
+        const char *p = strchr(shorts, c);
+        if (!p) {
+          continue;
+        }
+        idx = (size_t)(p - shorts);
+      }
+      vals[idx] = optarg ? optarg : "";
+    }
+  }
+  uint64_t t1 = now_ns();
+
+  printf("{\"impl\":\"getopt_long\",\"flags\":%zu,\"tokens\":%d,"
+         "\"style\":\"%s\",\"mix\":\"%s\",\"create_ns\":-1,\"freeze_ns\":-1,"
+         "\"ns_per_token\":%.2f,\"get_ns\":-1,\"allocs_per_parse\":-1,"
+         "\"peak_rss_kb\":%ld}\n",
+         in->nflags, in->argc - 1, style_names[style], mix_names[in->mix],
+         (double)(t1 - t0) / (double)reps / (double)(in->argc - 1),
+         peak_rss_kb());
+
+  free(opts);
+  free(optstring);
+  free(vals);
+  free(argv);
+}
+
+int main(int argc, char **argv) {
+  bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+
+  static const size_t full_flags[] = {10, 100, 1000, 10000};
+  static const size_t full_tokens[] = {10, 1000, 100000, 1000000};
+  static const size_t quick_flags[] = {10, 1000};
+  static const size_t quick_tokens[] = {10, 10000};
+
+  const size_t *nflags = quick ? quick_flags : full_flags;
+  const size_t *ntokens = quick ? quick_tokens : full_tokens;
+  size_t nf = quick ? 2 : 4;
+  size_t nt = quick ? 2 : 4;
+
+  for (size_t f = 0; f < nf; f++) {
+    for (size_t t = 0; t < nt; t++) {
+      for (int style = STYLE_LONG; style <= STYLE_BUNDLED; style++) {
+        for (int mix = MIX_STR; mix <= MIX_MIXED; mix++) {
+          bench_input_t in;
+          input_build(&in, nflags[f], ntokens[t], (bench_style_t)style,
+                      (bench_mix_t)mix);
+          bench_hay(&in, (bench_style_t)style);
+          // getopt_long compares every long option for every argument.
+          if (style != STYLE_LONG || nflags[f] * ntokens[t] <= 100000000ull) {
+            bench_getopt(&in, (bench_style_t)style);
+          }
+          input_free(&in);
+          fflush(stdout);
+        }
+      }
+    }
+  }
+  return 0;
+}
@@ -29,6 +29,24 @@
 #include <stddef.h>
 #endif
 
+#include <stdint.h>
+
+// Silence the deprecation of FT_NULL where the library itself must name it.
+#if defined(__clang__)
+#define HAY_FLAGS__DEPRECATED_PUSH                                             \
+  _Pragma("clang diagnostic push")                                             \
+      _Pragma("clang diagnostic ignored \"-Wdeprecated-declarations\"")
+#define HAY_FLAGS__DEPRECATED_POP _Pragma("clang diagnostic pop")
+#elif defined(__GNUC__)
+#define HAY_FLAGS__DEPRECATED_PUSH                                             \
+  _Pragma("GCC diagnostic push")                                               \
+      _Pragma("GCC diagnostic ignored \"-Wdeprecated-declarations\"")
+#define HAY_FLAGS__DEPRECATED_POP _Pragma("GCC diagnostic pop")
+#else
+#define HAY_FLAGS__DEPRECATED_PUSH
+#define HAY_FLAGS__DEPRECATED_POP
+#endif
+
 /**
  * @enum flag_ty_t
  * @brief Enum representing the type of a flag.
@@ -41,19 +59,90 @@ typedef enum {
                                                  ///< FT_BOOL instead
   FT_STR,                                        ///< String type flag.
   FT_INT,                                        ///< Integer type flag.
-  FT_BOOL                                        ///< Boolean type flag.
+  FT_BOOL,                                       ///< Boolean type flag.
+  FT_INT64,    ///< Signed 64-bit integer flag, in decimal or 0x hexadecimal.
+  FT_UINT64,   ///< Unsigned 64-bit integer flag, in decimal or 0x hexadecimal.
+  FT_DOUBLE,   ///< Floating-point flag.
+  FT_SIZE,     ///< Byte count with an optional binary suffix (e.g. 64M).
+  FT_DURATION, ///< Duration with units (e.g. 250ms, 1h30m), in nanoseconds.
+  FT_STR_LIST, ///< Repeatable string flag; every occurrence is appended.
+  FT_INT_LIST, ///< Repeatable 64-bit integer flag.
+  FT_COUNT,    ///< Flag without value counting its occurrences (e.g. -vvv).
+  FT_CHOICE    ///< One of a fixed set of strings, stored as its ID.
 } flag_ty_t;
 
+/**
+ * @struct flag_view
+ * @brief A pointer and length referring to bytes owned by someone else.
+ */
+typedef struct flag_view {
+  const char *ptr; ///< Start of the bytes.
+  size_t len;      ///< Number of bytes, not counting any terminator.
+} flag_view_t;
+
+/**
+ * @struct flag_list
+ * @brief The values of a list flag, in a contiguous growable array.
+ */
+typedef struct flag_list {
+  void *items;          ///< flag_view_t or int64_t items, depending on type.
+  size_t len;           ///< Number of items.
+  size_t cap;           ///< Number of items that fit before the next growth.
+  struct flag_ctx *own; ///< Internal: arena owned by the flag, if any.
+} flag_list_t;
+
 /**
  * @union flag_v_t
  * @brief Union to store the value of a flag.
  */
 typedef union {
-  const char *val_str; ///< Value if the flag is of type FT_STR.
-  int val_int;         ///< Value if the flag is of type FT_INT.
-  bool val_bool;       ///< Value if the flag is of type FT_BOOL.
+  const char *val_str;  ///< Value if the flag is of type FT_STR.
+  int val_int;          ///< Value if the flag is of type FT_INT.
+  bool val_bool;        ///< Value if the flag is of type FT_BOOL.
+  int64_t val_int64;    ///< Value if the flag is of type FT_INT64.
+  uint64_t val_uint64;  ///< Value if the flag is of type FT_UINT64.
+  double val_double;    ///< Value if the flag is of type FT_DOUBLE.
+  uint64_t val_size;    ///< Value in bytes if the flag is of type FT_SIZE.
+  int64_t val_duration; ///< Value in nanoseconds for FT_DURATION.
+  flag_view_t val_view; ///< FT_STR value with its length; ptr is val_str.
+  flag_list_t val_list; ///< Items of an FT_STR_LIST or FT_INT_LIST flag.
+  unsigned val_count;   ///< Number of occurrences of an FT_COUNT flag.
+  unsigned val_choice;  ///< ID of the value of an FT_CHOICE flag, i.e. its
+                        ///< index in the array of choices.
 } flag_v_t;
 
+/**
+ * @typedef flag_choices_t
+ * @brief The allowed values of FT_CHOICE flags, with a perfect hash over
+ *        them.
+ */
+typedef struct flag_choices flag_choices_t;
+
+/**
+ * @enum flag_src_t
+ * @brief Where the value of a flag came from, in increasing precedence.
+ *
+ * A source never overwrites a value set by a source of higher precedence.
+ */
+typedef enum {
+  FS_UNSET = 0, ///< The flag has not been set.
+  FS_CONFIG,    ///< Set from a config file.
+  FS_ENV,       ///< Set from an environment variable.
+  FS_ARGV       ///< Set from the command line (or a response file).
+} flag_src_t;
+
+/**
+ * @enum flag_opt_t
+ * @brief Option bits stored in flag_t::opts.
+ */
+typedef enum {
+  FO_BORROW = 1 << 0, ///< Store string values as pointers into argv instead
+                      ///< of copies. argv must outlive the value.
+  FO_OWNED = 1 << 6, ///< Internal: the string value was allocated by the
+                     ///< library and is released by hay_flags_destroy().
+  FO_ARENA = 1 << 7  ///< Internal: the flag lives in a flag_ctx_t arena.
+} flag_opt_t;
+
 /**
  * @struct flag
  * @brief Structure representing a command-line flag.
@@ -67,6 +156,17 @@ typedef struct flag {
   flag_ty_t type;  ///< The type of the flag (string, integer, boolean).
   flag_v_t val;    ///< The value of the flag.
   bool is_set;     ///< Boolean indicating if the flag has been set.
+  unsigned opts;   ///< Bitwise OR of flag_opt_t values.
+  flag_src_t src;  ///< The source that set the value, FS_UNSET if none.
+  const char *desc;   ///< One-line description for the help, or nullptr.
+  const char *defval; ///< Default value shown in the help, or nullptr.
+  const char *env;    ///< Environment variable bound to the flag, or nullptr
+                      ///< to derive one from a prefix.
+  uint64_t gen;       ///< Schema generation of the last delta that changed
+                      ///< the value, 0 if none did.
+  uint64_t seen;      ///< Internal: stamp of the last parse that set the
+                      ///< flag.
+  const flag_choices_t *choices; ///< Allowed values of an FT_CHOICE flag.
 } flag_t;
 
 /**
@@ -76,14 +176,86 @@ typedef struct flag {
  *
  * @param name The long name of the flag (e.g., "verbose").
  * @param short_name The short name of the flag (e.g., 'v'), use 0 if none.
- * @param type The type of the flag (FT_STR, FT_INT, FT_BOOL).
+ * @param type The type of the flag (FT_STR, FT_INT, FT_BOOL, ...).
  * @return A pointer to the newly created flag.
  *
- * @note The returned pointer must be freed by the caller after use.
+ * @note The returned pointer must be released with hay_flags_destroy().
  */
 flag_t *hay_flags_create(const char *name, const char short_name,
                          flag_ty_t type);
 
+/**
+ * @brief Releases a flag created by hay_flags_create().
+ *
+ * Frees the flag, its name, and any string value the library copied into it.
+ * Flags that live in a flag_ctx_t arena are left alone; they are released
+ * with their context.
+ *
+ * @param flag The flag to release. May be nullptr.
+ */
+void hay_flags_destroy(flag_t *flag);
+
+/**
+ * @brief Builds the set of allowed values of FT_CHOICE flags.
+ *
+ * The names get a perfect hash (hash and displace, one byte per pair of
+ * names plus a slot table a quarter larger than the set), so a value is
+ * resolved to its ID with one hash and one comparison when it is parsed.
+ * Assign the set to the flag_t::choices of any number of flags:
+ *
+ * @code
+ * enum { MODE_FAST, MODE_SAFE, MODE_DEBUG };
+ * static const char *const modes[] = {"fast", "safe", "debug", nullptr};
+ * flag_choices_t *mode_choices = hay_flags_choices_create(modes);
+ * flag_t *mode = hay_flags_create("mode", 'm', FT_CHOICE);
+ * mode->choices = mode_choices;
+ * // ... parse "--mode safe" ...
+ * switch (hay_flags_getchoice(mode, MODE_FAST)) { ... }
+ * @endcode
+ *
+ * A value that is not one of the choices fails the parse with FERR_CHOICE
+ * (`EINVAL`), naming the flag in the flag_error_t of the parse.
+ *
+ * @param names The allowed values, at most 255, terminated by nullptr. The
+ *              ID of each is its index. The array must outlive the set.
+ * @return A pointer to the new set, or nullptr on error (`errno` is set to
+ *         `EINVAL` for an empty or too long array, `EEXIST` for a repeated
+ *         name, or `ENOMEM`).
+ *
+ * @note The set must outlive the flags using it, and be released with
+ *       hay_flags_choices_destroy().
+ */
+flag_choices_t *hay_flags_choices_create(const char *const *names);
+
+/**
+ * @brief Releases a set of choices.
+ *
+ * @param choices The set to release. May be nullptr.
+ */
+void hay_flags_choices_destroy(flag_choices_t *choices);
+
+/**
+ * @brief Returns the name of a choice, e.g. to report an FT_CHOICE value.
+ *
+ * @param choices The set of choices.
+ * @param id The ID of the choice.
+ * @return The name, or nullptr if the ID is out of range.
+ */
+const char *hay_flags_choices_name(const flag_choices_t *choices,
+                                   unsigned id);
+
+/**
+ * @brief Sets the text describing a flag in the help.
+ *
+ * @param flag The flag to describe.
+ * @param desc One-line description, or nullptr.
+ * @param defval Default value as it should be shown, or nullptr.
+ *
+ * @note Both strings are referenced, not copied, and must outlive the flag.
+ *       Describe flags before the help of their schema is first rendered.
+ */
+void hay_flags_describe(flag_t *flag, const char *desc, const char *defval);
+
 /**
  * @brief Parses command-line arguments and sets the corresponding flags.
  *
@@ -95,11 +267,1119 @@ flag_t *hay_flags_create(const char *name, const char short_name,
  * @param argv The argument vector from main().
  * @return 0 on success, or a negative error code on failure.
  *
+ * Numeric values are checked strictly: trailing characters fail with
+ * `EINVAL` and values out of range for the flag type fail with `ERANGE`.
+ * The offending flag is left untouched and the remaining arguments are
+ * still parsed.
+ *
  * @note The flags array must contain all the possible flags that can be set
  *       by the command-line arguments.
  */
 int hay_flags_parse(flag_t **flags, int argc, char **argv);
 
+/**
+ * @brief Parses command-line arguments like hay_flags_parse(), with schema
+ *        options.
+ *
+ * Lets callers of the flag array API opt in to FSO_ABBREV and the other
+ * schema options without building a schema themselves.
+ *
+ * @param flags Array of pointers to flag_t structures, terminated by nullptr.
+ * @param opts Bitwise OR of flag_schema_opt_t values.
+ * @param argc The argument count from main().
+ * @param argv The argument vector from main().
+ * @return 0 on success, or -1 on failure with `errno` set, as
+ *         hay_flags_parse().
+ */
+int hay_flags_parse_opts(flag_t **flags, unsigned opts, int argc,
+                         char **argv);
+
+/**
+ * @struct flag_slot
+ * @brief A single entry of the long-name hash table of a schema.
+ */
+typedef struct flag_slot {
+  uint32_t hash; ///< Hash of the long name.
+  uint32_t idx;  ///< Index of the flag plus one, 0 if the slot is empty.
+  uint32_t name; ///< Offset of the long name in the name pool.
+  uint32_t len;  ///< Length of the long name.
+} flag_slot_t;
+
+/**
+ * @struct flag_sorted
+ * @brief A single entry of the sorted long-name index of a schema.
+ */
+typedef struct flag_sorted {
+  const char *name; ///< The long name.
+  uint32_t idx;     ///< Index of the flag plus one.
+} flag_sorted_t;
+
+/**
+ * @struct flag_schema
+ * @brief A frozen, hash-indexed set of flags.
+ *
+ * A schema is built once from a flag array and can then be used for any
+ * number of parses. Long names are looked up through a hash table and short
+ * names through a 256-entry table, so each argument is dispatched in constant
+ * time. The long names are copied back to back into one pool, and each hash
+ * slot holds the offset and length of its name, so a lookup reads the slot
+ * table and the pool and never follows a flag pointer.
+ *
+ * The layout is public only so that HAY_FLAGS_STATIC() can emit schemas at
+ * compile time. Treat every member as private. The index of a static schema,
+ * the sorted index and the help are built on first use under `lock` and then
+ * published, so threads sharing a schema may all make that first use.
+ */
+typedef struct flag_schema {
+  flag_t **flags;        ///< Copy of the flag array, terminated by nullptr.
+  size_t count;          ///< Number of flags in the schema.
+  flag_slot_t *slots;    ///< Open-addressing table over long names.
+  size_t cap;            ///< Number of slots (a power of two).
+  uint32_t shorts[256];  ///< Index plus one of each short name, 0 if none.
+  struct flag_ctx *ctx;  ///< Context owning the schema, nullptr if heap.
+  unsigned opts;         ///< Bitwise OR of flag_schema_opt_t values.
+  bool indexed;          ///< Whether slots has been filled.
+  bool lock;             ///< Held while a cache below is built.
+  char *help;            ///< Rendered help, once hay_flags_help() ran.
+  size_t help_len;       ///< Length of help in bytes.
+  flag_sorted_t *sorted; ///< Long names in order, once needed.
+  const char *names;     ///< Every long name, null-terminated, back to back
+                         ///< in the order of flags.
+  uint64_t gen;          ///< Generation of the last delta that changed a
+                         ///< flag.
+} flag_schema_t;
+
+/**
+ * @brief Builds a frozen schema from an array of flags.
+ *
+ * @param flags Array of pointers to flag_t structures, terminated by nullptr.
+ * @return A pointer to the new schema, or nullptr on error (`errno` is set to
+ *         `EINVAL`, `EEXIST` for duplicated names, or `ENOMEM`).
+ *
+ * @note The flags are referenced, not copied, and must outlive the schema.
+ *       The schema must be released with hay_flags_schema_destroy().
+ */
+flag_schema_t *hay_flags_schema_create(flag_t **flags);
+
+/**
+ * @brief Releases a schema created by hay_flags_schema_create().
+ *
+ * @param schema The schema to release. May be nullptr.
+ */
+void hay_flags_schema_destroy(flag_schema_t *schema);
+
+/**
+ * @brief Parses command-line arguments against a frozen schema.
+ *
+ * Behaves like hay_flags_parse(), but reuses the lookup tables of the schema
+ * instead of building them for every call.
+ *
+ * @param schema The schema built by hay_flags_schema_create() or declared
+ *               with HAY_FLAGS_STATIC().
+ * @param argc The argument count from main().
+ * @param argv The argument vector from main().
+ * @return 0 on success, or -1 on failure with `errno` set.
+ */
+int hay_flags_schema_parse(const flag_schema_t *schema, int argc, char **argv);
+
+/**
+ * @brief Applies a fragment of arguments to a schema that was already parsed.
+ *
+ * Meant for overrides received at run time, e.g. over a control socket:
+ * only the flags named in the fragment are touched, with the precedence of
+ * the command line. A list or count flag named in the fragment gets the
+ * values of the fragment instead of adding to the ones it had, and the items
+ * it replaces are released. Operands are ignored.
+ *
+ * Every delta that changes at least one value increments the generation of
+ * the schema and stores it in flag_t::gen of the flags it changed, so a
+ * caller can test whether anything it cares about changed without reading
+ * the values:
+ *
+ * @code
+ * uint64_t seen = hay_flags_schema_gen(schema);
+ * // ... later, after hay_flags_schema_apply() ...
+ * if (port->gen > seen) {
+ *   rebind(hay_flags_getint(port, 8080));
+ * }
+ * seen = hay_flags_schema_gen(schema);
+ * @endcode
+ *
+ * A value set to what it already was does not count as a change. That holds
+ * for lists and counts too: they are compared with the value they had once
+ * the whole fragment is applied, so `-v` leaves a count of 1 unchanged.
+ *
+ * @param schema The schema whose flags receive the values.
+ * @param argc The number of arguments in the fragment.
+ * @param argv The fragment, e.g. {"--port", "9090"}; argv[0] is an argument,
+ *             not a program name.
+ * @return The number of flags whose value changed, or -1 on failure with
+ *         `errno` set. Flags applied before the failing argument keep their
+ *         new value.
+ *
+ * @note Values are written in place: a delta must not race with readers of
+ *       the flags or with another parse of the schema.
+ */
+long hay_flags_schema_apply(flag_schema_t *schema, int argc, char **argv);
+
+/**
+ * @brief Returns the generation of a schema.
+ *
+ * @param schema The schema to read.
+ * @return The number of deltas that changed a value of the schema so far.
+ */
+uint64_t hay_flags_schema_gen(const flag_schema_t *schema);
+
+/**
+ * @brief Parses command-line arguments and leaves only the operands in argv.
+ *
+ * Same as hay_flags_schema_parse(), but the operands met during the parse
+ * (tokens that are neither flags nor values, and every token after `--`)
+ * are moved to `argv[1]`, `argv[2]`, ... in their original order, like a
+ * getopt() permutation without a second pass. `*argc` is set to one plus
+ * their number and `argv[*argc]` to nullptr. Only pointers are moved.
+ *
+ * @param schema The schema to parse against.
+ * @param argc Points to the argument count from main(); receives the new
+ *             count.
+ * @param argv The argument vector from main(); rewritten in place.
+ * @return 0 on success, or -1 on failure with `errno` set. The operands are
+ *         collected either way.
+ *
+ * @note Operands read from response files are not collected, since they
+ *       have no slot in argv. hay_flags_result_args() collects those too.
+ */
+int hay_flags_schema_parse_args(const flag_schema_t *schema, int *argc,
+                                char **argv);
+
+/**
+ * @brief Returns the help text of a schema, rendering it on first use.
+ *
+ * Every flag gets one line: its short and long names, a placeholder for its
+ * value, then, in an aligned column, its description and default value:
+ *
+ * @code
+ *   -p, --port <int>        Port to listen on (default: 8080)
+ *       --include <str>...  Add a directory to the search path
+ * @endcode
+ *
+ * The text is rendered once into a buffer cached by the schema and released
+ * with it, so later calls cost nothing.
+ *
+ * @param schema The schema to describe.
+ * @return The text, or a view with a nullptr ptr on error (`errno` is set to
+ *         `ENOMEM`).
+ *
+ * @note The cache is written under the lock of the schema, so threads
+ *       sharing the schema may all call this.
+ */
+flag_view_t hay_flags_help(const flag_schema_t *schema);
+
+/**
+ * @brief Writes a usage line and the help of a schema with one writev().
+ *
+ * @param schema The schema to describe.
+ * @param fd The file descriptor to write to (e.g. STDOUT_FILENO).
+ * @param usage Text written before the help (e.g. "Usage: app [options]\n"),
+ *              or nullptr.
+ * @return 0 on success, or -1 on failure with `errno` set.
+ */
+int hay_flags_print_help(const flag_schema_t *schema, int fd,
+                         const char *usage);
+
+/**
+ * @enum flag_schema_opt_t
+ * @brief Option bits applying to every flag of a schema.
+ */
+typedef enum {
+  FSO_BORROW = 1 << 0,         ///< Behave as if every flag had FO_BORROW set.
+  FSO_RESPONSE_FILES = 1 << 1, ///< Expand `@file` arguments into the
+                               ///< whitespace-separated tokens of the file.
+  FSO_ABBREV = 1 << 2          ///< Accept any unambiguous prefix of a long
+                               ///< name (e.g. --verb for --verbose).
+} flag_schema_opt_t;
+
+/**
+ * @brief Sets the options of a schema.
+ *
+ * @param schema The schema to configure.
+ * @param opts Bitwise OR of flag_schema_opt_t values, replacing the previous
+ *             options.
+ */
+void hay_flags_schema_set_opts(flag_schema_t *schema, unsigned opts);
+
+/**
+ * @brief Lists the flags whose long name starts with a prefix.
+ *
+ * Meant for shell completion: the prefix is located in a sorted index of the
+ * long names with two binary searches, so the cost does not depend on the
+ * number of flags that do not match. The index is built on first use (or
+ * when a schema with FSO_ABBREV is first parsed).
+ *
+ * @param schema The schema to search.
+ * @param word The word being completed, with or without its leading `--`.
+ * @param out Receives up to `max` matching flags, in the order of their
+ *            names. May be nullptr if `max` is 0.
+ * @param max The capacity of `out`.
+ * @return The number of matching flags, which may exceed `max`, or -1 with
+ *         `errno` set (`EINVAL`, `ENOMEM`).
+ */
+long hay_flags_complete(const flag_schema_t *schema, const char *word,
+                        const flag_t **out, size_t max);
+
+/**
+ * @name Static flag tables
+ *
+ * A flag table can be declared entirely at compile time with an X-macro list.
+ * Each entry is `X(T, id, short_name, type)`, where `T` must be passed through
+ * unchanged, `id` is a C identifier that doubles as the long name, and
+ * `short_name` is a character or 0:
+ *
+ * @code
+ * #define APP_FLAGS(X, T)                                                    \
+ *   X(T, port, 'p', FT_INT)                                                  \
+ *   X(T, dir, 'd', FT_STR)                                                   \
+ *   X(T, verbose, 0, FT_BOOL)
+ *
+ * HAY_FLAGS_STATIC(app_flags, APP_FLAGS);
+ *
+ * hay_flags_schema_parse(&app_flags, argc, argv);
+ * int port = hay_flags_getint(HAY_FLAGS_GET(app_flags, port), 8080);
+ * @endcode
+ *
+ * The flags, the pool of their names, the pointer array, the short-name table
+ * and the hash slots are all static storage; nothing is allocated. A repeated
+ * id (and therefore a repeated long name) or a repeated short name is a
+ * compile error. The first use fills the hash slots in place, under the lock
+ * of the schema, so threads may share a static schema from the start, each
+ * parsing into its own result.
+ * @{
+ */
+
+/// Declares a static schema named `name` from the X-macro list `LIST`.
+#define HAY_FLAGS_STATIC(name, LIST)                                           \
+  enum { LIST(HAY_FLAGS__ENUM, name) name##__count };                          \
+  static inline void name##__check_shorts(int c) {                             \
+    switch (c) { /* A duplicated short name is a duplicated case label. */    \
+      LIST(HAY_FLAGS__CASE, name)                                              \
+    default:                                                                   \
+      break;                                                                   \
+    }                                                                          \
+  }                                                                            \
+  static const struct name##__names {                                          \
+    LIST(HAY_FLAGS__NAME, name) char hay__end;                                 \
+  } name##_names = {LIST(HAY_FLAGS__NAME_INIT, name)};                         \
+  static flag_t name##_store[] = {LIST(HAY_FLAGS__FLAG, name)};                \
+  static flag_t *name##_flags[] = {LIST(HAY_FLAGS__PTR, name) nullptr};        \
+  static flag_slot_t name##_slots[HAY_FLAGS__CAP(name##__count)];              \
+  HAY_FLAGS__DIAG_PUSH                                                         \
+  static flag_schema_t name = {                                                \
+      .flags = name##_flags,                                                   \
+      .count = name##__count,                                                  \
+      .slots = name##_slots,                                                   \
+      .cap = HAY_FLAGS__CAP(name##__count),                                    \
+      .shorts = {LIST(HAY_FLAGS__SHORT, name)},                                \
+      .names = (const char *)&name##_names,                                    \
+  };                                                                           \
+  HAY_FLAGS__DIAG_POP
+
+/// Pointer to the flag `id` of the static schema `name`.
+#define HAY_FLAGS_GET(name, id) (&name##_store[name##__##id])
+
+#define HAY_FLAGS__ENUM(T, id, s, ty) T##__##id,
+#define HAY_FLAGS__CASE(T, id, s, ty)                                          \
+  case ((s) ? (s) : -1 - T##__##id):                                           \
+    break;
+// The names are the members of one struct of char arrays, which lays them
+// out back to back with their terminators: a name pool built by the compiler.
+#define HAY_FLAGS__NAME(T, id, s, ty) char id[sizeof(#id)];
+#define HAY_FLAGS__NAME_INIT(T, id, s, ty) .id = #id,
+#define HAY_FLAGS__FLAG(T, id, s, ty)                                          \
+  [T##__##id] = {                                                              \
+      .name = (char *)T##_names.id, .short_name = (s), .type = (ty)},
+#define HAY_FLAGS__PTR(T, id, s, ty) &T##_store[T##__##id],
+#define HAY_FLAGS__SHORT(T, id, s, ty)                                         \
+  [(unsigned char)(s)] = (s) ? T##__##id + 1 : 0,
+#define HAY_FLAGS__CAP(n)                                                      \
+  ((n) * 2 <= 8       ? 8                                                      \
+   : (n) * 2 <= 64    ? 64                                                     \
+   : (n) * 2 <= 512   ? 512                                                    \
+   : (n) * 2 <= 4096  ? 4096                                                   \
+   : (n) * 2 <= 32768 ? 32768                                                  \
+                      : 262144)
+
+// Flags without a short name all initialise shorts[0] to 0.
+#if defined(__clang__)
+#define HAY_FLAGS__DIAG_PUSH                                                   \
+  _Pragma("clang diagnostic push")                                             \
+      _Pragma("clang diagnostic ignored \"-Winitializer-overrides\"")
+#define HAY_FLAGS__DIAG_POP _Pragma("clang diagnostic pop")
+#elif defined(__GNUC__)
+#define HAY_FLAGS__DIAG_PUSH                                                   \
+  _Pragma("GCC diagnostic push")                                               \
+      _Pragma("GCC diagnostic ignored \"-Woverride-init\"")
+#define HAY_FLAGS__DIAG_POP _Pragma("GCC diagnostic pop")
+#else
+#define HAY_FLAGS__DIAG_PUSH
+#define HAY_FLAGS__DIAG_POP
+#endif
+
+/** @} */
+
+/**
+ * @brief Loads a `key = value` config file as a low-precedence source.
+ *
+ * The file is mapped with mmap() and scanned line by line. Keys are looked up
+ * in the schema by their long name; lines with unknown keys are skipped
+ * without converting their value. Values set here are tagged FS_CONFIG and
+ * never overwrite a value tagged FS_ARGV, whichever is loaded first.
+ *
+ * @param schema The schema receiving the values.
+ * @param path Path of the config file.
+ * @return 0 on success, or -1 on failure with `errno` set.
+ */
+int hay_flags_schema_load_config(const flag_schema_t *schema, const char *path);
+
+/**
+ * @brief Loads environment variables as a source below the command line.
+ *
+ * The environment is scanned once. A variable named by the flag_t::env of a
+ * flag sets that flag. Otherwise, if its name starts with @p prefix, the rest
+ * of the name is lowered, its underscores become dashes, and it is looked up
+ * in the schema like a long name: with the prefix "MYAPP_", `MYAPP_LOG_LEVEL`
+ * sets `--log-level`. A flag with an flag_t::env of its own is not set
+ * through a derived name. Variables matching no flag are skipped without
+ * converting their value.
+ *
+ * Values set here are tagged FS_ENV: they override a config file and never
+ * overwrite a value tagged FS_ARGV, whichever is loaded first.
+ *
+ * @param schema The schema receiving the values.
+ * @param prefix Prefix of the derived variable names, or nullptr to only use
+ *               the names set in flag_t::env.
+ * @param envp The environment to read, terminated by nullptr, or nullptr for
+ *             `environ`.
+ * @return 0 on success, or -1 on failure with `errno` set (`EEXIST` if two
+ *         flags are bound to the same variable).
+ */
+int hay_flags_schema_load_env(const flag_schema_t *schema, const char *prefix,
+                              char *const *envp);
+
+/**
+ * @brief Saves the set flags of a schema into a position-independent blob.
+ *
+ * The blob holds offsets, never pointers, so it can be written to a file or
+ * a pipe, or inherited through a shared mapping, and loaded by another
+ * process running the same build with hay_flags_schema_load_snapshot().
+ *
+ * @param schema The schema to save.
+ * @param len Receives the size of the blob in bytes.
+ * @return The blob, to be released with free(), or nullptr on failure with
+ *         `errno` set.
+ */
+void *hay_flags_snapshot(const flag_schema_t *schema, size_t *len);
+
+/**
+ * @brief Loads a snapshot into the flags of a schema, without parsing.
+ *
+ * Numbers are copied and strings point into the blob. The items of lists are
+ * allocated, those of string lists still pointing into the blob. Flags are
+ * matched by long name and keep the source they had when saved; a flag of
+ * the schema that is not in the snapshot is left alone. The whole blob is
+ * checked before any flag is written.
+ *
+ * @param schema The schema receiving the values.
+ * @param blob The snapshot, aligned on 8 bytes (as returned by malloc() or
+ *             mmap()). It must outlive the values.
+ * @param len Size of the snapshot in bytes.
+ * @return 0 on success, or -1 on failure with `errno` set (`EINVAL` if the
+ *         blob is malformed or a flag changed type).
+ */
+int hay_flags_schema_load_snapshot(const flag_schema_t *schema,
+                                   const void *blob, size_t len);
+
+/**
+ * @struct flag_allocator
+ * @brief Allocator hooks used by a flag_ctx_t to obtain arena blocks.
+ */
+typedef struct flag_allocator {
+  void *(*alloc)(void *ud, size_t size); ///< Returns a block, or nullptr.
+  void (*free)(void *ud, void *ptr);     ///< Releases a block from alloc.
+  void *ud;                              ///< Passed to both hooks.
+} flag_allocator_t;
+
+/**
+ * @struct flag_ctx_stats
+ * @brief Allocation counters of a flag_ctx_t.
+ */
+typedef struct flag_ctx_stats {
+  size_t allocs;   ///< Calls made to the allocator since creation.
+  size_t used;     ///< Bytes handed out from the arena since the last reset.
+  size_t reserved; ///< Bytes currently held in arena blocks.
+} flag_ctx_stats_t;
+
+/**
+ * @typedef flag_ctx_t
+ * @brief A parse context owning a bump arena.
+ *
+ * Flags, names, schemas and string values allocated through a context all
+ * live in its arena and are released together by hay_flags_ctx_reset() or
+ * hay_flags_ctx_destroy(). A reset keeps the arena blocks, so a program that
+ * repeats the same work after a reset does not touch the heap again.
+ */
+typedef struct flag_ctx flag_ctx_t;
+
+/**
+ * @brief Creates a parse context.
+ *
+ * @param alloc Allocator hooks, or nullptr to use malloc() and free(). The
+ *              structure is copied.
+ * @return A pointer to the new context, or nullptr on error (`errno` is set
+ *         to `ENOMEM`).
+ */
+flag_ctx_t *hay_flags_ctx_create(const flag_allocator_t *alloc);
+
+/**
+ * @brief Releases a context and everything allocated in it.
+ *
+ * @param ctx The context to release. May be nullptr.
+ */
+void hay_flags_ctx_destroy(flag_ctx_t *ctx);
+
+/**
+ * @brief Releases everything allocated in a context, keeping its blocks.
+ *
+ * Every flag, schema and value obtained from the context becomes invalid.
+ *
+ * @param ctx The context to reset.
+ */
+void hay_flags_ctx_reset(flag_ctx_t *ctx);
+
+/**
+ * @brief Creates a flag inside a context arena.
+ *
+ * Same as hay_flags_create(), but the flag and its name are allocated in the
+ * arena and released with it. If the flag is parsed into without a context,
+ * pass it to hay_flags_destroy() to free the values copied to the heap; the
+ * flag itself stays in the arena.
+ *
+ * @param ctx The context owning the flag.
+ * @param name The long name of the flag.
+ * @param short_name The short name of the flag, 0 if none.
+ * @param type The type of the flag.
+ * @return A pointer to the new flag, or nullptr on error (`errno` is set).
+ */
+flag_t *hay_flags_ctx_create_flag(flag_ctx_t *ctx, const char *name,
+                                  const char short_name, flag_ty_t type);
+
+/**
+ * @brief Builds a frozen schema inside a context arena.
+ *
+ * Same as hay_flags_schema_create(), but the schema is released with the
+ * context; hay_flags_schema_destroy() is a no-op on it.
+ *
+ * @param ctx The context owning the schema.
+ * @param flags Array of pointers to flag_t structures, terminated by nullptr.
+ * @return A pointer to the new schema, or nullptr on error (`errno` is set).
+ */
+flag_schema_t *hay_flags_ctx_schema(flag_ctx_t *ctx, flag_t **flags);
+
+/**
+ * @brief Parses command-line arguments, copying string values into a context.
+ *
+ * Same as hay_flags_schema_parse(), except that string values are copied
+ * into the arena of `ctx` instead of the heap.
+ *
+ * @param ctx The context receiving the copied values.
+ * @param schema The schema to parse against.
+ * @param argc The argument count from main().
+ * @param argv The argument vector from main().
+ * @return 0 on success, or -1 on failure with `errno` set.
+ */
+int hay_flags_ctx_parse(flag_ctx_t *ctx, const flag_schema_t *schema, int argc,
+                        char **argv);
+
+/**
+ * @brief Loads a config file, keeping it mapped for the life of a context.
+ *
+ * Same as hay_flags_schema_load_config(), but string values are copied into
+ * the arena, or point into the mapping if borrowed.
+ *
+ * @param ctx The context owning the mapping and copied values.
+ * @param schema The schema receiving the values.
+ * @param path Path of the config file.
+ * @return 0 on success, or -1 on failure with `errno` set.
+ */
+int hay_flags_ctx_load_config(flag_ctx_t *ctx, const flag_schema_t *schema,
+                              const char *path);
+
+/**
+ * @brief Renders the set flags of a schema back to a minimal argv.
+ *
+ * Emits one `--name` or `--name=value` token per value, in schema order, so
+ * that parsing the result sets the same values (for re-exec'ing a child).
+ * Values from a config file are rendered too.
+ *
+ * @param ctx The context the argv and its tokens are allocated in.
+ * @param schema The schema to render.
+ * @param argv0 The program name stored in argv[0].
+ * @param argc Receives the number of tokens, argv[0] included.
+ * @return The argv, terminated by nullptr, or nullptr on failure with `errno`
+ *         set (`ENOTSUP` for an FT_DOUBLE value in a minimal build).
+ */
+char **hay_flags_ctx_to_argv(flag_ctx_t *ctx, const flag_schema_t *schema,
+                             const char *argv0, int *argc);
+
+/**
+ * @brief Reads the allocation counters of a context.
+ *
+ * @param ctx The context to inspect.
+ * @param out Receives the counters.
+ */
+void hay_flags_ctx_stats(const flag_ctx_t *ctx, flag_ctx_stats_t *out);
+
+/**
+ * @enum flag_err_t
+ * @brief Error codes reported by the reentrant parsing API.
+ */
+typedef enum {
+  FERR_OK = 0,  ///< No error.
+  FERR_ARGS,    ///< Invalid arguments were passed to the library.
+  FERR_NOMEM,   ///< Memory allocation failed.
+  FERR_FORMAT,  ///< A value is not valid for the type of its flag.
+  FERR_RANGE,   ///< A value is out of range for the type of its flag.
+  FERR_MISSING, ///< A flag that takes a value ended the arguments.
+  FERR_IO,       ///< A response file could not be read.
+  FERR_DEPTH,    ///< Response files are nested too deeply.
+  FERR_AMBIGUOUS, ///< An abbreviated long name matches several flags.
+  FERR_CHOICE,    ///< The value of an FT_CHOICE flag is not one of its
+                  ///< choices.
+  FERR_CMD_DEPTH  ///< Commands of a command tree are nested too deeply.
+} flag_err_t;
+
+/**
+ * @struct flag_error
+ * @brief Details of the first error raised by a parse.
+ */
+typedef struct flag_error {
+  flag_err_t code;    ///< The kind of error, FERR_OK if none.
+  int errnum;         ///< The matching errno value, 0 if none.
+  int arg;            ///< Index in argv of the offending argument, -1 if the
+                      ///< error is not tied to an argument.
+  const flag_t *flag; ///< The flag the error is about, or nullptr.
+} flag_error_t;
+
+/**
+ * @brief Returns a static description of an error code.
+ *
+ * @param code The error code.
+ * @return A string that must not be modified or freed.
+ */
+const char *hay_flags_strerror(flag_err_t code);
+
+/**
+ * @typedef flag_result_t
+ * @brief The values set by one parse of an immutable schema.
+ *
+ * A result holds its own copy of every flag of a schema, plus an arena for
+ * the values it copies. Parsing into a result never writes to the schema or
+ * to its flags, so any number of threads may parse against the same schema
+ * at once, each into its own result. A result can be reused: each parse
+ * starts from a clean state and, once its arena has grown to fit, does not
+ * allocate.
+ */
+typedef struct flag_result flag_result_t;
+
+/**
+ * @brief Creates a result bound to a schema.
+ *
+ * Indexes a HAY_FLAGS_STATIC() schema if that has not happened yet. Several
+ * threads may do so at once; the index is built once and then only read.
+ *
+ * @param schema The schema the result is parsed against. It must outlive the
+ *               result.
+ * @return A pointer to the new result, or nullptr on error (`errno` is set).
+ */
+flag_result_t *hay_flags_result_create(const flag_schema_t *schema);
+
+/**
+ * @brief Releases a result and every value copied into it.
+ *
+ * @param res The result to release. May be nullptr.
+ */
+void hay_flags_result_destroy(flag_result_t *res);
+
+/**
+ * @brief Parses command-line arguments into a result.
+ *
+ * The result is cleared first. Parsing carries on after an error, and the
+ * first error is kept for hay_flags_result_error(). Options set on the
+ * schema since the result was created apply. Neither `errno` nor any stream
+ * is touched, except that errno-setting calls made for response files or to
+ * index the schema may clobber `errno`.
+ *
+ * @param res The result receiving the values.
+ * @param argc The argument count from main().
+ * @param argv The argument vector from main().
+ * @return FERR_OK on success, or the code of the first error.
+ */
+flag_err_t hay_flags_parse_r(flag_result_t *res, int argc, char **argv);
+
+/**
+ * @brief Returns the copy of a flag held by a result.
+ *
+ * The copy can be passed to any of the getters.
+ *
+ * @param res The result to read.
+ * @param flag A flag of the schema of the result, or any flag with the same
+ *             long name.
+ * @return The copy, or nullptr if the schema has no such flag.
+ */
+flag_t *hay_flags_result_get(flag_result_t *res, const flag_t *flag);
+
+/**
+ * @brief Iterates over the flags set by the last parse of a result.
+ *
+ * The result keeps one bit per flag, so the scan costs one word read per 64
+ * flags instead of one flag read per flag:
+ *
+ * @code
+ * size_t pos = 0;
+ * for (flag_t *f; (f = hay_flags_result_next(res, &pos));) {
+ *   // f->name was given.
+ * }
+ * @endcode
+ *
+ * @param res The result to read.
+ * @param pos Cursor, 0 to start; moved past the returned flag.
+ * @return The next set flag in schema order, or nullptr if there is none.
+ */
+flag_t *hay_flags_result_next(flag_result_t *res, size_t *pos);
+
+/**
+ * @brief Returns the first error raised by the last parse of a result.
+ *
+ * The `flag` member points to the copy held by the result.
+ *
+ * @param res The result to read.
+ * @return The error details; `code` is FERR_OK if the parse succeeded.
+ */
+const flag_error_t *hay_flags_result_error(const flag_result_t *res);
+
+/**
+ * @brief Returns the operands met by the last parse of a result.
+ *
+ * Operands are the tokens that are neither flags nor values, plus every
+ * token after `--`, in order. The array holds pointers to the arguments
+ * themselves (or into a response file mapped by the result); no string is
+ * copied.
+ *
+ * @param res The result to read.
+ * @param count Receives the number of operands.
+ * @return The operands, or nullptr if there are none. Valid until the next
+ *         parse into the result.
+ */
+char *const *hay_flags_result_args(const flag_result_t *res, size_t *count);
+
+/**
+ * @struct flag_argv
+ * @brief One argument vector of a batch parse.
+ */
+typedef struct flag_argv {
+  int argc;    ///< The number of arguments.
+  char **argv; ///< The arguments, starting with the program name.
+} flag_argv_t;
+
+/**
+ * @brief Parses several argument vectors in parallel.
+ *
+ * Vector `i` is parsed into `results[i]` with hay_flags_parse_r(). The work is
+ * shared by the calling thread and up to `threads - 1` worker threads, which
+ * pick vectors from a common counter. The workers are started by each call
+ * and exit when the batch is done, so repeated batches, whose setup would
+ * otherwise be paid every time, go through a flag_pool_t instead.
+ *
+ * @param results One distinct result per vector. They may be bound to
+ *                different schemas.
+ * @param inputs The argument vectors.
+ * @param n The number of vectors.
+ * @param threads The number of threads to use, or 0 for one per online CPU.
+ *                The batch runs on fewer threads if workers cannot be
+ *                started.
+ * @return The number of vectors whose parse failed, or -1 with `errno` set to
+ *         `EINVAL` if `results` or `inputs` is nullptr.
+ */
+long hay_flags_parse_batch(flag_result_t **results, const flag_argv_t *inputs,
+                           size_t n, unsigned threads);
+
+/**
+ * @typedef flag_pool_t
+ * @brief Worker threads kept between batch parses.
+ */
+typedef struct flag_pool flag_pool_t;
+
+/**
+ * @brief Starts the worker threads of a pool for repeated batch parses.
+ *
+ * The `threads - 1` workers wait on a condition variable between batches,
+ * so a batch costs no thread creation. A minimal build starts none.
+ *
+ * @param threads The number of threads to use, the calling thread of each
+ *                batch included, or 0 for one per online CPU. Pools run on
+ *                fewer threads if workers cannot be started.
+ * @return The pool, to be released with hay_flags_pool_destroy(), or
+ *         nullptr with `errno` set to `ENOMEM`.
+ */
+flag_pool_t *hay_flags_pool_create(unsigned threads);
+
+/**
+ * @brief Stops the workers of a pool and releases it.
+ *
+ * @param pool The pool to release. May be nullptr. No batch may be running.
+ */
+void hay_flags_pool_destroy(flag_pool_t *pool);
+
+/**
+ * @brief Parses several argument vectors on the workers of a pool.
+ *
+ * Same as hay_flags_parse_batch(), on the workers of `pool` and the calling
+ * thread. A pool runs one batch at a time; a batch posted by another thread
+ * meanwhile waits for it to finish.
+ *
+ * @param pool The pool.
+ * @param results One distinct result per vector.
+ * @param inputs The argument vectors.
+ * @param n The number of vectors.
+ * @return The number of vectors whose parse failed, or -1 with `errno` set to
+ *         `EINVAL` if `pool`, `results` or `inputs` is nullptr.
+ */
+long hay_flags_pool_parse(flag_pool_t *pool, flag_result_t **results,
+                          const flag_argv_t *inputs, size_t n);
+
+/**
+ * @brief Parses a NUL-separated argument blob into a result, without an argv.
+ *
+ * The blob has the layout of `/proc/<pid>/cmdline`: the program name, then
+ * every argument, each followed by a NUL byte. Tokens are parsed where they
+ * lie, so no argv is built and, once the arena of the result has grown to
+ * fit, nothing is allocated. String values, list items and operands are
+ * views into the blob whatever FO_BORROW says; the blob must outlive them.
+ * A last token without its NUL (a truncated read) is the only one copied.
+ * Error indexes count tokens, the program name being token 0.
+ *
+ * @param res The result receiving the values.
+ * @param blob The arguments. May be nullptr if `len` is 0.
+ * @param len Length of the blob in bytes.
+ * @return FERR_OK on success, or the code of the first error.
+ *
+ * @note Response files are expanded if the schema enables them, as they are
+ *       from argv: only do so for blobs you trust.
+ */
+flag_err_t hay_flags_parse_blob_r(flag_result_t *res, const char *blob,
+                                  size_t len);
+
+/**
+ * @brief Receives each result of hay_flags_scan_blobs().
+ *
+ * @param res The result, holding the values parsed from the blob until the
+ *            next one is parsed.
+ * @param i The index of the blob.
+ * @param ud The pointer given to hay_flags_scan_blobs().
+ * @return 0 to go on, anything else to stop the scan.
+ */
+typedef int (*flag_scan_fn_t)(flag_result_t *res, size_t i, void *ud);
+
+/**
+ * @brief Parses many blobs against one schema, reusing a single result.
+ *
+ * Each blob is parsed with hay_flags_parse_blob_r() into `res`, then handed
+ * to `fn` along with its index, e.g. to classify a process by its flags. The
+ * result is cleared before every blob, so the whole scan allocates nothing
+ * once its arena fits the largest blob.
+ *
+ * @code
+ * flag_view_t blobs[] = {{buf0, len0}, {buf1, len1}};
+ * hay_flags_scan_blobs(res, blobs, 2, classify, &counts);
+ * @endcode
+ *
+ * @param res The result every blob is parsed into.
+ * @param blobs The blobs, as views of their bytes.
+ * @param n The number of blobs.
+ * @param fn Called after each parse, whether it failed or not.
+ * @param ud Passed to fn.
+ * @return The number of blobs whose parse failed among those scanned, or -1
+ *         with `errno` set to `EINVAL` if `res` or `fn` is nullptr, or
+ *         `blobs` is nullptr and `n` is not 0.
+ */
+long hay_flags_scan_blobs(flag_result_t *res, const flag_view_t *blobs,
+                          size_t n, flag_scan_fn_t fn, void *ud);
+
+/**
+ * @typedef flag_live_t
+ * @brief Published versions of the values of a schema, read without locks.
+ *
+ * Meant for values read on hot paths by many threads while another thread
+ * reloads them (e.g. with hay_flags_schema_apply()). Every version is a
+ * frozen copy of the values of the schema; readers pin the current one with
+ * a single atomic load and never block, and a writer publishes a new one
+ * with hay_flags_live_publish(). A replaced version is freed once every
+ * reader that could hold it has left its read section (epoch-based
+ * reclamation):
+ *
+ * @code
+ * // Worker thread
+ * flag_reader_t *r = hay_flags_live_reader(live);
+ * for (;;) {
+ *   hay_flags_live_enter(r);
+ *   int port = hay_flags_getint(hay_flags_live_get(r, port_flag), 8080);
+ *   const char *host = hay_flags_getstr(hay_flags_live_get(r, host_flag), "");
+ *   hay_flags_live_exit(r);
+ *   // port and host always come from the same version.
+ * }
+ *
+ * // Reload thread
+ * hay_flags_schema_apply(schema, argc, delta);
+ * hay_flags_live_publish(live);
+ * @endcode
+ */
+typedef struct flag_live flag_live_t;
+
+/**
+ * @typedef flag_reader_t
+ * @brief The slot a reader thread of a flag_live_t announces itself in.
+ */
+typedef struct flag_reader flag_reader_t;
+
+/**
+ * @brief Publishes the current values of a schema as its first version.
+ *
+ * @param schema The schema whose values are published. It must outlive the
+ *               returned object.
+ * @return A pointer to the new object, or nullptr on failure with `errno`
+ *         set.
+ */
+flag_live_t *hay_flags_live_create(const flag_schema_t *schema);
+
+/**
+ * @brief Releases every version and every reader slot.
+ *
+ * @param live The object to release. May be nullptr.
+ *
+ * @note No reader may still be using the object.
+ */
+void hay_flags_live_destroy(flag_live_t *live);
+
+/**
+ * @brief Publishes the current values of the schema as a new version.
+ *
+ * Strings and list items are copied, so the flags of the schema can change
+ * again right away. Readers entering afterwards see the new version; the
+ * versions no reader can still hold are freed.
+ *
+ * @param live The object to publish to.
+ * @return 0 on success, or -1 on failure with `errno` set; the previous
+ *         version stays current.
+ *
+ * @note Publishing must not race with another publish or with changes to
+ *       the flags of the schema: writers are serialised by the caller.
+ */
+int hay_flags_live_publish(flag_live_t *live);
+
+/**
+ * @brief Hands out a reader slot for the calling thread.
+ *
+ * Slots are cheap to keep: take one per thread when it starts, and release
+ * it when it ends.
+ *
+ * @param live The object to read.
+ * @return The slot, or nullptr on failure with `errno` set.
+ */
+flag_reader_t *hay_flags_live_reader(flag_live_t *live);
+
+/**
+ * @brief Gives a reader slot back for another thread to use.
+ *
+ * @param reader The slot, outside of any read section. May be nullptr.
+ */
+void hay_flags_live_reader_release(flag_reader_t *reader);
+
+/**
+ * @brief Enters a read section and pins the current version.
+ *
+ * Read sections do not nest, and each slot is used by one thread at a time.
+ *
+ * @param reader The slot of the calling thread.
+ * @return The generation of the schema (see hay_flags_schema_gen()) when the
+ *         pinned version was published, so values derived from it can be
+ *         cached until it changes.
+ */
+uint64_t hay_flags_live_enter(flag_reader_t *reader);
+
+/**
+ * @brief Returns the copy of a flag in the version pinned by a reader.
+ *
+ * @param reader The slot of the calling thread, inside a read section.
+ * @param flag The flag to look up, by its long name.
+ * @return The copy, valid until hay_flags_live_exit(), or nullptr if the
+ *         schema has no such flag. It must not be modified.
+ */
+flag_t *hay_flags_live_get(flag_reader_t *reader, const flag_t *flag);
+
+/**
+ * @brief Leaves a read section, unpinning its version.
+ *
+ * @param reader The slot of the calling thread.
+ */
+void hay_flags_live_exit(flag_reader_t *reader);
+
+/**
+ * @struct flag_cmd
+ * @brief A subcommand, as declared by the application.
+ *
+ * Commands are declared in arrays terminated by an entry whose name is
+ * nullptr, usually static ones:
+ *
+ * @code
+ * static const flag_cmd_t remote_cmds[] = {
+ *     {.name = "add", .build = build_remote_add},
+ *     {.name = "remove", .schema = &remote_remove_flags},
+ *     {0},
+ * };
+ * static const flag_cmd_t cmds[] = {
+ *     {.name = "clone", .build = build_clone},
+ *     {.name = "remote", .schema = &remote_flags, .subs = remote_cmds},
+ *     {0},
+ * };
+ * @endcode
+ */
+typedef struct flag_cmd {
+  const char *name;            ///< Name of the command on the command line.
+  const flag_schema_t *schema; ///< Flags of the command, or nullptr to
+                               ///< call build instead.
+  flag_schema_t *(*build)(flag_ctx_t *ctx,
+                          void *ud); ///< Builds the flags of the command in
+                                     ///< ctx. Called at most once, the
+                                     ///< first time the command is selected.
+  void *ud;                          ///< Passed to build.
+  const struct flag_cmd *subs;       ///< Nested commands, or nullptr.
+} flag_cmd_t;
+
+/**
+ * @typedef flag_cmds_t
+ * @brief A command tree, dispatching on the first operand of each level.
+ */
+typedef struct flag_cmds flag_cmds_t;
+
+/**
+ * @brief Creates a command tree inside a context arena.
+ *
+ * Nothing is done for the commands themselves until a parse selects them:
+ * each level is hashed when the parse reaches it and the flags of a command
+ * are built when it is selected.
+ *
+ * @param ctx The context owning the tree, the built schemas and the values
+ *            copied by its parses.
+ * @param globals Flags accepted before and after every command, or nullptr.
+ * @param cmds The top-level commands, terminated by an entry with a nullptr
+ *             name. The array must outlive the tree.
+ * @return A pointer to the new tree, or nullptr on error (`errno` is set).
+ */
+flag_cmds_t *hay_flags_cmds_create(flag_ctx_t *ctx,
+                                   const flag_schema_t *globals,
+                                   const flag_cmd_t *cmds);
+
+/**
+ * @brief Parses command-line arguments through a command tree.
+ *
+ * The first operand is looked up among the top-level commands. If it names
+ * one, the following arguments are parsed against the flags of that command,
+ * and its own first operand is looked up among its nested commands, and so
+ * on. A flag unknown to the selected command is looked up in its parents and
+ * then in the global flags, so global flags may appear anywhere. An operand
+ * that names no command ends the descent. The options of the innermost
+ * schema (e.g. FSO_RESPONSE_FILES) apply.
+ *
+ * Each parse first unsets the flags the previous parse of the tree set and
+ * releases the values it copied, so parsing in a loop does not grow the
+ * context.
+ *
+ * @param cmds The command tree.
+ * @param argc The argument count from main().
+ * @param argv The argument vector from main().
+ * @param selected Receives the innermost selected command, or nullptr if
+ *                 none was given. May be nullptr.
+ * @return 0 on success, or -1 on failure with `errno` set (`EEXIST` if two
+ *         commands of a level share a name, the error of a build callback,
+ *         or the errors of hay_flags_schema_parse()).
+ */
+int hay_flags_cmds_parse(flag_cmds_t *cmds, int argc, char **argv,
+                         const flag_cmd_t **selected);
+
+/**
+ * @struct flag_stats
+ * @brief What one parse did, as reported to the statistics hook.
+ */
+typedef struct flag_stats {
+  uint64_t tokens;        ///< Tokens scanned, including those of response
+                          ///< files and the lines of config files.
+  uint64_t long_matches;  ///< Flags matched by their long name.
+  uint64_t short_matches; ///< Flags matched by their short name.
+  uint64_t unknown;       ///< Flag-like tokens (or bundled characters) that
+                          ///< matched no flag.
+  uint64_t conv_failures; ///< Values rejected by the type of their flag.
+  uint64_t missing;       ///< Flags left waiting for their value.
+  uint64_t allocs;        ///< Heap or arena blocks allocated by the parse.
+  uint64_t ns_index;      ///< Time spent indexing and building schemas.
+  uint64_t ns_io;         ///< Time spent opening and mapping files.
+  uint64_t ns_total;      ///< Time spent in the whole parse.
+} flag_stats_t;
+
+/**
+ * @brief Receives the statistics of every parse.
+ *
+ * @param schema The schema parsed against (the innermost one for a command
+ *               tree).
+ * @param stats The statistics of the parse.
+ * @param ud The pointer given to hay_flags_set_stats_hook().
+ */
+typedef void (*flag_stats_hook_t)(const flag_schema_t *schema,
+                                  const flag_stats_t *stats, void *ud);
+
+/**
+ * @brief Installs a process-wide hook called at the end of every parse.
+ *
+ * Every parse function reports to the hook, config file loads included.
+ * Counters are always collected, but clocks are only read while a hook is
+ * installed. When the library is built with `-DSTATS_flags=OFF`, counting
+ * compiles down to nothing and this function fails.
+ *
+ * @param hook The hook, or nullptr to remove it. Parses running on several
+ *             threads call it concurrently.
+ * @param ud Passed to the hook.
+ * @return 0 on success, or -1 with `errno` set to `ENOTSUP` if statistics
+ *         are compiled out.
+ *
+ * @note The hook may be replaced while other threads parse. A parse reports
+ *       to the old hook or the new one, always with the matching `ud`.
+ */
+int hay_flags_set_stats_hook(flag_stats_hook_t hook, void *ud);
+
+/**
+ * @def HAY_FLAGS_INLINE
+ * @brief Define before including this header to inline the getters.
+ *
+ * Every hay_flags_get*() function then becomes a `static inline` function
+ * defined in `<hay/flags_get.h>`, which compiles down to a check of the flag
+ * and a load instead of a call; through a shared library, that call goes
+ * through the PLT. The library still exports every getter, so translation
+ * units built with and without it can be mixed.
+ */
+#ifdef HAY_FLAGS_INLINE
+#define HAY_FLAGS__GETTER static inline
+#else
+#define HAY_FLAGS__GETTER
+#endif
+
 /**
  * @brief Retrieves the value of a null flag, or a default if not set.
  *
@@ -111,7 +1391,7 @@ int hay_flags_parse(flag_t **flags, int argc, char **argv);
  * @return The null value of the flag, or defval if not set.
  */
 __attribute__((deprecated("Not recommended. Use hay_flags_getbool() instead "
-                          "(with FT_BOOL as the type)"))) bool
+                          "(with FT_BOOL as the type)"))) HAY_FLAGS__GETTER bool
 hay_flags_getnull(flag_t *flag, const bool defval);
 
 /**
@@ -124,7 +1404,56 @@ hay_flags_getnull(flag_t *flag, const bool defval);
  * @param defval The default value to return if the flag is not set.
  * @return The integer value of the flag, or defval if not set.
  */
-int hay_flags_getint(flag_t *flag, const int defval);
+HAY_FLAGS__GETTER int hay_flags_getint(flag_t *flag, const int defval);
+
+/**
+ * @brief Retrieves the value of an FT_INT64 flag, or a default if not set.
+ *
+ * @param flag Pointer to the flag to retrieve the value from.
+ * @param defval The default value to return if the flag is not set.
+ * @return The value of the flag, or defval if not set.
+ */
+HAY_FLAGS__GETTER int64_t
+hay_flags_getint64(flag_t *flag, const int64_t defval);
+
+/**
+ * @brief Retrieves the value of an FT_UINT64 flag, or a default if not set.
+ *
+ * @param flag Pointer to the flag to retrieve the value from.
+ * @param defval The default value to return if the flag is not set.
+ * @return The value of the flag, or defval if not set.
+ */
+HAY_FLAGS__GETTER uint64_t
+hay_flags_getuint64(flag_t *flag, const uint64_t defval);
+
+/**
+ * @brief Retrieves the value of an FT_DOUBLE flag, or a default if not set.
+ *
+ * @param flag Pointer to the flag to retrieve the value from.
+ * @param defval The default value to return if the flag is not set.
+ * @return The value of the flag, or defval if not set.
+ */
+HAY_FLAGS__GETTER double hay_flags_getdouble(flag_t *flag, const double defval);
+
+/**
+ * @brief Retrieves the value of an FT_SIZE flag, or a default if not set.
+ *
+ * @param flag Pointer to the flag to retrieve the value from.
+ * @param defval The default value to return if the flag is not set.
+ * @return The value of the flag in bytes, or defval if not set.
+ */
+HAY_FLAGS__GETTER uint64_t
+hay_flags_getsize(flag_t *flag, const uint64_t defval);
+
+/**
+ * @brief Retrieves the value of an FT_DURATION flag, or a default if not set.
+ *
+ * @param flag Pointer to the flag to retrieve the value from.
+ * @param defval The default value to return if the flag is not set.
+ * @return The value of the flag in nanoseconds, or defval if not set.
+ */
+HAY_FLAGS__GETTER int64_t
+hay_flags_getduration(flag_t *flag, const int64_t defval);
 
 /**
  * @brief Retrieves the value of a string flag, or a default if not set.
@@ -139,7 +1468,67 @@ int hay_flags_getint(flag_t *flag, const int defval);
  * @note The returned string is owned by the flag structure and should not
  *       be freed by the caller.
  */
-const char *hay_flags_getstr(flag_t *flag, const char *defval);
+HAY_FLAGS__GETTER const char
+*hay_flags_getstr(flag_t *flag, const char *defval);
+
+/**
+ * @brief Retrieves a string flag as a pointer and length, or a default.
+ *
+ * With FO_BORROW or FSO_BORROW, the view points straight into the argument
+ * that supplied the value; nothing is copied.
+ *
+ * @param flag Pointer to the flag to retrieve the value from.
+ * @param defval The default value to return if the flag is not set.
+ * @return The value of the flag, or defval if not set.
+ */
+HAY_FLAGS__GETTER flag_view_t
+hay_flags_getview(flag_t *flag, const flag_view_t defval);
+
+/**
+ * @brief Retrieves the items of an FT_STR_LIST flag without copying them.
+ *
+ * @param flag Pointer to the flag to retrieve the items from.
+ * @param count Receives the number of items, 0 if the flag is not set.
+ * @return The items, in the order they were given, or nullptr if the flag is
+ *         not set or not an FT_STR_LIST flag. Every item is null-terminated.
+ *         The array is valid until the flag is parsed into again.
+ */
+HAY_FLAGS__GETTER const flag_view_t
+*hay_flags_getstrs(flag_t *flag, size_t *count);
+
+/**
+ * @brief Retrieves the items of an FT_INT_LIST flag without copying them.
+ *
+ * @param flag Pointer to the flag to retrieve the items from.
+ * @param count Receives the number of items, 0 if the flag is not set.
+ * @return The items, in the order they were given, or nullptr if the flag is
+ *         not set or not an FT_INT_LIST flag. The array is valid until the
+ *         flag is parsed into again.
+ */
+HAY_FLAGS__GETTER const int64_t *hay_flags_getints(flag_t *flag, size_t *count);
+
+/**
+ * @brief Retrieves the ID of the value of an FT_CHOICE flag.
+ *
+ * The value was resolved when it was parsed, so this is a plain load instead
+ * of a chain of strcmp() calls.
+ *
+ * @param flag Pointer to the flag to retrieve the value from.
+ * @param defval The default value to return if the flag is not set.
+ * @return The index of the value in the array given to
+ *         hay_flags_choices_create(), or defval if not set.
+ */
+HAY_FLAGS__GETTER int hay_flags_getchoice(flag_t *flag, const int defval);
+
+/**
+ * @brief Retrieves the number of occurrences of an FT_COUNT flag.
+ *
+ * @param flag Pointer to the flag to retrieve the value from.
+ * @param defval The default value to return if the flag is not set.
+ * @return The count (e.g. 3 for `-vvv`), or defval if not set.
+ */
+HAY_FLAGS__GETTER unsigned
+hay_flags_getcount(flag_t *flag, const unsigned defval);
 
 /**
  * @deprecated Use hay_flags_getbool() with FT_BOOL as the type
@@ -152,6 +1541,10 @@ const char *hay_flags_getstr(flag_t *flag, const char *defval);
  * @param defval The default value to return if the flag is not set.
  * @return The boolean value of the flag, or defval if not set.
  */
-bool hay_flags_getbool(flag_t *flag, const bool defval);
+HAY_FLAGS__GETTER bool hay_flags_getbool(flag_t *flag, const bool defval);
+
+#ifdef HAY_FLAGS_INLINE
+#include <hay/flags_get.h>
+#endif
 
 #endif // HAY_FLAGS_H
@@ -0,0 +1,264 @@
+/**
+ * @file flags_get.h
+ * @brief Definitions of the hay/flags getters.
+ *
+ * Not meant to be included directly. `<hay/flags.h>` includes it when
+ * `HAY_FLAGS_INLINE` is defined, so that every getter is a `static inline`
+ * function the compiler folds into a field load and a default; the library
+ * includes it once to export the same getters as ordinary functions.
+ */
+
+#ifndef HAY_FLAGS_GET_H
+#define HAY_FLAGS_GET_H
+
+#include <hay/flags.h>
+
+/**
+ * @deprecated Use hay_flags_getbool() with FT_BOOL as the type
+ * @brief Retrieves the value of a null flag or returns a default value.
+ *
+ * Checks if the specified flag is a null type and if it is set. If so, returns
+ * true; otherwise, returns the provided default value.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param defval The default value to return if the flag is not set or not a
+ * null type.
+ * @return true if the flag is a null type and is set, otherwise returns defval.
+ */
+HAY_FLAGS__DEPRECATED_PUSH
+HAY_FLAGS__GETTER bool hay_flags_getnull(flag_t *flag, const bool defval) {
+  if (flag && flag->is_set && flag->type == FT_NULL) {
+    return true;
+  }
+  return defval;
+}
+HAY_FLAGS__DEPRECATED_POP
+
+/**
+ * @brief Retrieves the value of an integer flag or returns a default value.
+ *
+ * Checks if the specified flag is of integer type and if it is set. If so,
+ * returns the flag's integer value; otherwise, returns the provided default
+ * value.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param defval The default value to return if the flag is not set or not an
+ * integer type.
+ * @return The integer value of the flag if set, otherwise returns defval.
+ */
+HAY_FLAGS__GETTER int hay_flags_getint(flag_t *flag, const int defval) {
+  if (flag && flag->is_set && flag->type == FT_INT) {
+    return flag->val.val_int;
+  }
+  return defval;
+}
+
+/**
+ * @brief Retrieves the value of an FT_INT64 flag or returns a default value.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param defval The default value to return if the flag is not set or not an
+ * FT_INT64 flag.
+ * @return The value of the flag if set, otherwise returns defval.
+ */
+HAY_FLAGS__GETTER int64_t
+hay_flags_getint64(flag_t *flag, const int64_t defval) {
+  if (flag && flag->is_set && flag->type == FT_INT64) {
+    return flag->val.val_int64;
+  }
+  return defval;
+}
+
+/**
+ * @brief Retrieves the value of an FT_UINT64 flag or returns a default value.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param defval The default value to return if the flag is not set or not an
+ * FT_UINT64 flag.
+ * @return The value of the flag if set, otherwise returns defval.
+ */
+HAY_FLAGS__GETTER uint64_t
+hay_flags_getuint64(flag_t *flag, const uint64_t defval) {
+  if (flag && flag->is_set && flag->type == FT_UINT64) {
+    return flag->val.val_uint64;
+  }
+  return defval;
+}
+
+/**
+ * @brief Retrieves the value of an FT_DOUBLE flag or returns a default value.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param defval The default value to return if the flag is not set or not an
+ * FT_DOUBLE flag.
+ * @return The value of the flag if set, otherwise returns defval.
+ */
+HAY_FLAGS__GETTER double
+hay_flags_getdouble(flag_t *flag, const double defval) {
+  if (flag && flag->is_set && flag->type == FT_DOUBLE) {
+    return flag->val.val_double;
+  }
+  return defval;
+}
+
+/**
+ * @brief Retrieves the value of an FT_SIZE flag or returns a default value.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param defval The default value to return if the flag is not set or not an
+ * FT_SIZE flag.
+ * @return The value of the flag in bytes if set, otherwise returns defval.
+ */
+HAY_FLAGS__GETTER uint64_t
+hay_flags_getsize(flag_t *flag, const uint64_t defval) {
+  if (flag && flag->is_set && flag->type == FT_SIZE) {
+    return flag->val.val_size;
+  }
+  return defval;
+}
+
+/**
+ * @brief Retrieves the value of an FT_DURATION flag or returns a default.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param defval The default value to return if the flag is not set or not an
+ * FT_DURATION flag.
+ * @return The value of the flag in nanoseconds if set, otherwise returns
+ * defval.
+ */
+HAY_FLAGS__GETTER int64_t
+hay_flags_getduration(flag_t *flag, const int64_t defval) {
+  if (flag && flag->is_set && flag->type == FT_DURATION) {
+    return flag->val.val_duration;
+  }
+  return defval;
+}
+
+/**
+ * @brief Retrieves the value of a string flag or returns a default value.
+ *
+ * Checks if the specified flag is of string type and if it is set. If so,
+ * returns the flag's string value; otherwise, returns the provided default
+ * value.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param defval The default value to return if the flag is not set or not a
+ * string type.
+ * @return The string value of the flag if set, otherwise returns defval.
+ */
+HAY_FLAGS__GETTER const char
+*hay_flags_getstr(flag_t *flag, const char *defval) {
+  if (flag && flag->is_set && flag->type == FT_STR) {
+    return flag->val.val_str;
+  }
+  return defval;
+}
+
+/**
+ * @brief Retrieves a string flag as a view or returns a default value.
+ *
+ * Checks if the specified flag is of string type and if it is set. If so,
+ * returns the pointer and length of its value; otherwise, returns the
+ * provided default value.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param defval The default value to return if the flag is not set or not a
+ * string type.
+ * @return The view of the flag value if set, otherwise returns defval.
+ */
+HAY_FLAGS__GETTER flag_view_t
+hay_flags_getview(flag_t *flag, const flag_view_t defval) {
+  if (flag && flag->is_set && flag->type == FT_STR) {
+    return flag->val.val_view;
+  }
+  return defval;
+}
+
+/**
+ * @brief Retrieves the items of an FT_STR_LIST flag.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param count Receives the number of items.
+ * @return The items, or nullptr if the flag is not set or not an FT_STR_LIST
+ * flag.
+ */
+HAY_FLAGS__GETTER const flag_view_t
+*hay_flags_getstrs(flag_t *flag, size_t *count) {
+  if (flag && flag->is_set && flag->type == FT_STR_LIST) {
+    *count = flag->val.val_list.len;
+    return flag->val.val_list.items;
+  }
+  *count = 0;
+  return nullptr;
+}
+
+/**
+ * @brief Retrieves the items of an FT_INT_LIST flag.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param count Receives the number of items.
+ * @return The items, or nullptr if the flag is not set or not an FT_INT_LIST
+ * flag.
+ */
+HAY_FLAGS__GETTER const int64_t
+*hay_flags_getints(flag_t *flag, size_t *count) {
+  if (flag && flag->is_set && flag->type == FT_INT_LIST) {
+    *count = flag->val.val_list.len;
+    return flag->val.val_list.items;
+  }
+  *count = 0;
+  return nullptr;
+}
+
+/**
+ * @brief Retrieves the ID of the value of an FT_CHOICE flag or returns a
+ * default value.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param defval The default value to return if the flag is not set or not an
+ * FT_CHOICE flag.
+ * @return The ID of the choice if set, otherwise returns defval.
+ */
+HAY_FLAGS__GETTER int hay_flags_getchoice(flag_t *flag, const int defval) {
+  if (flag && flag->is_set && flag->type == FT_CHOICE) {
+    return (int)flag->val.val_choice;
+  }
+  return defval;
+}
+
+/**
+ * @brief Retrieves the count of an FT_COUNT flag or returns a default value.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param defval The default value to return if the flag is not set or not an
+ * FT_COUNT flag.
+ * @return The number of occurrences if set, otherwise returns defval.
+ */
+HAY_FLAGS__GETTER unsigned
+hay_flags_getcount(flag_t *flag, const unsigned defval) {
+  if (flag && flag->is_set && flag->type == FT_COUNT) {
+    return flag->val.val_count;
+  }
+  return defval;
+}
+
+/**
+ * @brief Retrieves the value of a boolean flag or returns a default value.
+ *
+ * Checks if the specified flag is of boolean type and if it is set. If so,
+ * returns the flag's boolean value; otherwise, returns the provided default
+ * value.
+ *
+ * @param flag Pointer to the flag to check.
+ * @param defval The default value to return if the flag is not set or not a
+ * boolean type.
+ * @return The boolean value of the flag if set, otherwise returns defval.
+ */
+HAY_FLAGS__GETTER bool hay_flags_getbool(flag_t *flag, const bool defval) {
+  if (flag && flag->is_set && flag->type == FT_BOOL) {
+    return flag->val.val_bool;
+  }
+  return defval;
+}
+
+#endif // HAY_FLAGS_GET_H
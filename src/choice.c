@@ -0,0 +1,204 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Most choices a set can hold; IDs plus one are stored in a byte.
+#define FLAGS_CHOICE_MAX 255
+/// Seeds tried at one table size before the table grows.
+#define FLAGS_CHOICE_SEEDS 64
+
+/**
+ * @brief Picks the slot of a name from its hash and the displacement of its
+ *        bucket.
+ *
+ * @param h Hash of the name.
+ * @param d Displacement of the bucket of the name.
+ * @param n Number of slots.
+ * @return The slot, below n.
+ */
+static inline uint32_t flags_choice_slot(uint32_t h, uint8_t d, uint32_t n) {
+  h ^= d * 0x9e3779b9u;
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  return (uint32_t)(((uint64_t)h * n) >> 32);
+}
+
+/**
+ * @brief Places every name of a set with one seed.
+ *
+ * Names are hashed into buckets of about two, and the buckets are placed
+ * largest first: each gets the first displacement that sends all its names
+ * to free slots.
+ *
+ * @param c The set; its displacements and slots are overwritten.
+ * @return 1 if every name got a slot of its own, 0 if a bucket found no
+ *         displacement, or -1 with `errno` set to `EEXIST` if two names are
+ *         the same.
+ */
+static int flags_choices_try(flag_choices_t *c) {
+  uint32_t nb = c->bmask + 1;
+  uint32_t hash[FLAGS_CHOICE_MAX];
+  uint8_t keys[FLAGS_CHOICE_MAX];       // Names grouped by bucket.
+  uint32_t start[FLAGS_CHOICE_MAX + 2]; // First key of each bucket.
+  uint8_t order[FLAGS_CHOICE_MAX + 1];  // Buckets, largest first.
+
+  memset(start, 0, (nb + 1) * sizeof(start[0]));
+  for (uint32_t i = 0; i < c->count; i++) {
+    const char *name = c->names[i];
+    hash[i] = flags_choice_hash(c->seed, name, strlen(name));
+    start[(hash[i] & c->bmask) + 1]++;
+  }
+  for (uint32_t b = 0; b < nb; b++) {
+    start[b + 1] += start[b];
+  }
+  uint32_t fill[FLAGS_CHOICE_MAX + 1];
+  memcpy(fill, start, nb * sizeof(fill[0]));
+  for (uint32_t i = 0; i < c->count; i++) {
+    keys[fill[hash[i] & c->bmask]++] = (uint8_t)i;
+  }
+  for (uint32_t b = 0; b < nb; b++) { // Insertion sort: buckets are few.
+    uint32_t size = start[b + 1] - start[b];
+    uint32_t j = b;
+    while (j && start[order[j - 1] + 1] - start[order[j - 1]] < size) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = (uint8_t)b;
+  }
+
+  memset(c->slots, 0, c->nslots);
+  for (uint32_t k = 0; k < nb; k++) {
+    uint32_t b = order[k];
+    const uint8_t *in = keys + start[b];
+    uint32_t n = start[b + 1] - start[b];
+    for (uint32_t i = 0; i < n; i++) {
+      for (uint32_t j = 0; j < i; j++) {
+        if (hash[in[i]] == hash[in[j]]) {
+          if (strcmp(c->names[in[i]], c->names[in[j]]) == 0) {
+            errno = EEXIST; // The same choice twice.
+            return -1;
+          }
+          return 0; // No displacement separates them under this seed.
+        }
+      }
+    }
+    uint32_t d = 0;
+    for (; d < 256; d++) {
+      uint32_t i = 0;
+      for (; i < n; i++) {
+        uint32_t s = flags_choice_slot(hash[in[i]], (uint8_t)d, c->nslots);
+        if (c->slots[s]) {
+          break;
+        }
+        c->slots[s] = (uint8_t)(in[i] + 1);
+      }
+      if (i == n) {
+        break;
+      }
+      while (i--) { // Undo the names placed with this displacement.
+        c->slots[flags_choice_slot(hash[in[i]], (uint8_t)d, c->nslots)] = 0;
+      }
+    }
+    if (d == 256) {
+      return 0;
+    }
+    c->disp[b] = (uint8_t)d;
+  }
+  return 1;
+}
+
+/**
+ * @brief Builds a perfect hash over a set of choices.
+ *
+ * Hash and displace: the names are hashed into buckets, and each bucket is
+ * given a displacement that sends its names to free slots of a table only a
+ * quarter larger than the set. A set of 255 names takes a few hundred bytes.
+ * Lookups then hash once, mix in the displacement and compare once.
+ *
+ * @param names The allowed values, terminated by nullptr.
+ * @return Pointer to the new set, or nullptr if an error occurs. In case of
+ *         error, `errno` is set to indicate the error.
+ */
+flag_choices_t *hay_flags_choices_create(const char *const *names) {
+  size_t count = 0;
+  while (names && names[count]) {
+    count++;
+  }
+  if (!count || count > FLAGS_CHOICE_MAX) {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  uint32_t nb = 1;
+  while (nb * 2 < count) {
+    nb <<= 1;
+  }
+  uint32_t nslots = (uint32_t)(count + count / 4 + 1);
+  for (int grow = 0; grow < 8; grow++, nslots += nslots / 4) {
+    flag_choices_t *c = malloc(sizeof(flag_choices_t) + nb + nslots);
+    if (!c) {
+      errno = ENOMEM;
+      return nullptr;
+    }
+    *c = (flag_choices_t){names, (uint32_t)count, 0, nb - 1, nslots,
+                          c->disp + nb};
+    for (uint32_t seed = 1; seed <= FLAGS_CHOICE_SEEDS; seed++) {
+      c->seed = seed * 0x9e3779b9u;
+      int r = flags_choices_try(c);
+      if (r != 0) {
+        if (r < 0) {
+          free(c);
+          return nullptr;
+        }
+        return c;
+      }
+    }
+    free(c);
+  }
+  errno = ENOMEM; // Unreachable in practice for 255 names.
+  return nullptr;
+}
+
+/**
+ * @brief Releases a set of choices.
+ *
+ * @param choices The set to release. May be nullptr.
+ */
+void hay_flags_choices_destroy(flag_choices_t *choices) {
+  free(choices);
+}
+
+/**
+ * @brief Returns the name of a choice.
+ *
+ * @param choices The set of choices.
+ * @param id The ID of the choice.
+ * @return The name, or nullptr if the ID is out of range.
+ */
+const char *hay_flags_choices_name(const flag_choices_t *choices,
+                                   unsigned id) {
+  if (!choices || id >= choices->count) {
+    return nullptr;
+  }
+  return choices->names[id];
+}
+
+/**
+ * @brief Resolves a value to the ID of a choice.
+ *
+ * @param c The set of choices.
+ * @param v The value; it does not need to be null-terminated.
+ * @param len Length of the value in bytes.
+ * @return The ID, or -1 if the value is not one of the choices.
+ */
+int flags_choices_find(const flag_choices_t *c, const char *v, size_t len) {
+  uint32_t h = flags_choice_hash(c->seed, v, len);
+  uint8_t id = c->slots[flags_choice_slot(h, c->disp[h & c->bmask], c->nslots)];
+  if (!id) {
+    return -1;
+  }
+  const char *name = c->names[id - 1];
+  return strncmp(name, v, len) == 0 && name[len] == '\0' ? id - 1 : -1;
+}
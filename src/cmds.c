@@ -0,0 +1,301 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <string.h>
+
+/**
+ * @struct flags_cmd_node
+ * @brief What a command tree has materialized for one command.
+ */
+typedef struct flags_cmd_node {
+  const flag_schema_t *schema;  ///< Flags of the command, once selected.
+  struct flags_cmd_level *subs; ///< Index of its nested commands, once
+                                ///< reached.
+} flags_cmd_node_t;
+
+/**
+ * @struct flags_cmd_level
+ * @brief Hash index over the commands declared in one array.
+ */
+typedef struct flags_cmd_level {
+  const flag_cmd_t *cmds;  ///< The declared commands.
+  size_t count;            ///< Number of commands.
+  flag_slot_t *slots;      ///< Open-addressing table over the names.
+  size_t cap;              ///< Number of slots (a power of two).
+  flags_cmd_node_t *nodes; ///< One node per command.
+} flags_cmd_level_t;
+
+/**
+ * @struct flag_cmds
+ * @brief A command tree and the context everything it builds lives in.
+ */
+struct flag_cmds {
+  flag_ctx_t *ctx;              ///< Arena of the tree.
+  flag_ctx_t *vals;             ///< Values of the last parse, rewound by the
+                                ///< next one.
+  const flag_schema_t *globals; ///< Flags accepted at every level.
+  const flag_cmd_t *cmds;       ///< The top-level commands.
+  flags_cmd_level_t *root;      ///< Their index, once built.
+  uint64_t stamp;               ///< Stamp of the last parse, 0 if none.
+};
+
+/**
+ * @brief Hashes the names of a command array into a new level.
+ *
+ * @param ctx The arena to allocate the level in.
+ * @param cmds The commands, terminated by an entry with a nullptr name.
+ * @return The level, or nullptr with `errno` set (`EEXIST` if two commands
+ *         share a name, `ENOMEM`).
+ */
+static flags_cmd_level_t *flags_cmds_index(flag_ctx_t *ctx,
+                                           const flag_cmd_t *cmds) {
+  size_t count = 0;
+  while (cmds[count].name) {
+    count++;
+  }
+  size_t cap = 8;
+  while (cap < count * 2) {
+    cap <<= 1;
+  }
+
+  flags_cmd_level_t *level = flags_ctx_alloc(ctx, sizeof(flags_cmd_level_t));
+  flag_slot_t *slots = flags_ctx_alloc(ctx, cap * sizeof(flag_slot_t));
+  flags_cmd_node_t *nodes =
+      flags_ctx_alloc(ctx, (count ? count : 1) * sizeof(flags_cmd_node_t));
+  if (!level || !slots || !nodes) {
+    return nullptr;
+  }
+  memset(slots, 0, cap * sizeof(flag_slot_t));
+  memset(nodes, 0, count * sizeof(flags_cmd_node_t));
+  *level = (flags_cmd_level_t){cmds, count, slots, cap, nodes};
+
+  size_t mask = cap - 1;
+  for (size_t i = 0; i < count; i++) {
+    const char *name = cmds[i].name;
+    uint32_t len = (uint32_t)strlen(name);
+    uint32_t h = flags_hash(name, len);
+    for (size_t s = h & mask;; s = (s + 1) & mask) {
+      if (!slots[s].idx) {
+        slots[s] = (flag_slot_t){h, (uint32_t)(i + 1), 0, len};
+        break;
+      }
+      if (slots[s].hash == h &&
+          strcmp(cmds[slots[s].idx - 1].name, name) == 0) {
+        errno = EEXIST; // Two commands share a name.
+        return nullptr;
+      }
+    }
+  }
+  return level;
+}
+
+/**
+ * @brief Looks up a command by name in a level.
+ *
+ * @param level The level to search.
+ * @param name Start of the name; it does not need to be null-terminated.
+ * @param len Length of the name in bytes.
+ * @return Index of the command plus one, or 0 if there is none.
+ */
+static uint32_t flags_cmds_find(const flags_cmd_level_t *level,
+                                const char *name, size_t len) {
+  uint32_t h = flags_hash(name, len);
+  size_t mask = level->cap - 1;
+  for (size_t s = h & mask;; s = (s + 1) & mask) {
+    const flag_slot_t *slot = &level->slots[s];
+    if (!slot->idx) {
+      return 0;
+    }
+    if (slot->hash == h && slot->len == len &&
+        memcmp(level->cmds[slot->idx - 1].name, name, len) == 0) {
+      return slot->idx;
+    }
+  }
+}
+
+/**
+ * @brief Records the error left in `errno` by a failed build or index.
+ */
+static void flags_cmds_fail(flags_parser_t *p) {
+  int err = errno;
+  flags_parser_fail(p, err == ENOMEM ? FERR_NOMEM : FERR_ARGS, err, nullptr);
+}
+
+/**
+ * @brief Descends into the command named by an operand, if any.
+ *
+ * Only the first operand of each level may name a command; any other operand
+ * ends the descent. Selecting a command builds its schema and makes it the
+ * schema of the parser, the previous one becoming an enclosing scope.
+ *
+ * @param p The parser state; p->level and p->arena must be set.
+ * @param tok The operand, null-terminated.
+ * @param len Length of the operand in bytes.
+ * @return true if the operand named a command, false if it is a plain
+ *         operand.
+ */
+bool flags_cmds_select(flags_parser_t *p, const char *tok, size_t len) {
+  flags_cmd_level_t *level = p->level;
+  p->level = nullptr;
+
+  uint32_t idx = flags_cmds_find(level, tok, len);
+  if (!idx) {
+    return false;
+  }
+  if (p->nscopes == FLAGS_CMD_DEPTH) {
+    flags_parser_fail(p, FERR_CMD_DEPTH, ELOOP, nullptr);
+    return true;
+  }
+
+  const flag_cmd_t *cmd = &level->cmds[idx - 1];
+  flags_cmd_node_t *node = &level->nodes[idx - 1];
+  uint64_t t0 = FLAGS_CLOCK(p);
+  if (!node->schema) {
+    const flag_schema_t *schema = cmd->schema;
+    if (!schema) {
+      // A command without flags of its own only takes inherited ones.
+      flag_t *none[] = {nullptr};
+      schema = cmd->build ? cmd->build(p->arena, cmd->ud)
+                          : flags_schema_build(none, p->arena);
+      if (!schema) {
+        flags_cmds_fail(p);
+        return true;
+      }
+    }
+    if (flags_schema_ready(schema) != 0) {
+      flags_cmds_fail(p);
+      return true;
+    }
+    node->schema = schema;
+  }
+  if (cmd->subs && !node->subs) {
+    node->subs = flags_cmds_index(p->arena, cmd->subs);
+    if (!node->subs) {
+      flags_cmds_fail(p);
+      return true;
+    }
+  }
+
+  FLAGS_STAT_SINCE(p, ns_index, t0);
+  p->scopes[p->nscopes++] = p->schema;
+  p->schema = node->schema;
+  p->level = node->subs;
+  p->selected = cmd;
+  return true;
+}
+
+/**
+ * @brief Creates a command tree inside a context arena.
+ *
+ * @param ctx The context owning the tree.
+ * @param globals Flags accepted at every level, or nullptr.
+ * @param cmds The top-level commands, terminated by an entry with a nullptr
+ *             name.
+ * @return Pointer to the new tree, or nullptr if an error occurs. In case of
+ *         error, `errno` is set to indicate the error.
+ */
+flag_cmds_t *hay_flags_cmds_create(flag_ctx_t *ctx,
+                                   const flag_schema_t *globals,
+                                   const flag_cmd_t *cmds) {
+  if (!ctx || !cmds) {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  if (!globals) {
+    flag_t *none[] = {nullptr};
+    globals = flags_schema_build(none, ctx);
+  } else if (flags_schema_ready(globals) != 0) {
+    return nullptr;
+  }
+  flag_cmds_t *tree = flags_ctx_alloc(ctx, sizeof(flag_cmds_t));
+  flag_ctx_t *vals = tree ? flags_ctx_create_kid(ctx) : nullptr;
+  if (!globals || !vals) {
+    return nullptr;
+  }
+  *tree = (flag_cmds_t){ctx, vals, globals, cmds, nullptr, 0};
+  return tree;
+}
+
+/**
+ * @brief Unsets the flags of a schema that the last parse of a tree set.
+ *
+ * @param schema The schema, or nullptr.
+ * @param stamp Stamp of that parse.
+ */
+static void flags_cmds_forget(const flag_schema_t *schema, uint64_t stamp) {
+  for (size_t i = 0; schema && i < schema->count; i++) {
+    flag_t *flag = schema->flags[i];
+    if (flag->seen != stamp) {
+      continue;
+    }
+    if (flag->type == FT_STR_LIST || flag->type == FT_INT_LIST) {
+      flag_list_t *l = &flag->val.val_list;
+      l->len = 0;
+      if (!l->own) { // The items were in the values arena.
+        l->items = nullptr;
+        l->cap = 0;
+      }
+    } else {
+      flag->val = (flag_v_t){0};
+    }
+    flag->is_set = false;
+    flag->src = FS_UNSET;
+    flag->seen = 0;
+  }
+}
+
+/**
+ * @brief Unsets the flags of a level and of the levels below it.
+ */
+static void flags_cmds_forget_level(const flags_cmd_level_t *level,
+                                    uint64_t stamp) {
+  for (size_t i = 0; level && i < level->count; i++) {
+    flags_cmds_forget(level->nodes[i].schema, stamp);
+    flags_cmds_forget_level(level->nodes[i].subs, stamp);
+  }
+}
+
+/**
+ * @brief Parses command-line arguments through a command tree.
+ *
+ * @param cmds The command tree.
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line argument vector.
+ * @param selected Receives the innermost selected command, or nullptr.
+ * @return 0 on success, or -1 if an error occurs. In case of error, `errno` is
+ *         set to indicate the error.
+ */
+int hay_flags_cmds_parse(flag_cmds_t *cmds, int argc, char **argv,
+                         const flag_cmd_t **selected) {
+  if (selected) {
+    *selected = nullptr;
+  }
+  if (!cmds || !argv) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (!cmds->root) {
+    cmds->root = flags_cmds_index(cmds->ctx, cmds->cmds);
+    if (!cmds->root) {
+      return -1;
+    }
+  }
+
+  // Values of the last parse are dropped with the arena holding them.
+  if (cmds->stamp) {
+    flags_cmds_forget(cmds->globals, cmds->stamp);
+    flags_cmds_forget_level(cmds->root, cmds->stamp);
+    hay_flags_ctx_reset(cmds->vals);
+  }
+
+  flags_parser_t p;
+  flags_parser_init(&p, cmds->globals, cmds->vals);
+  p.level = cmds->root;
+  p.arena = cmds->ctx;
+  cmds->stamp = p.stamp;
+  flags_parser_run(&p, argc, argv);
+  if (selected) {
+    *selected = p.selected;
+  }
+  return flags_parser_finish(&p);
+}
@@ -0,0 +1,173 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Returns whether a character is blank within a config line.
+ */
+static inline bool flags_is_blank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * @brief Trims blanks on both ends of a slice.
+ */
+static void flags_trim(char **start, char **end) {
+  while (*start < *end && flags_is_blank(**start)) {
+    (*start)++;
+  }
+  while (*end > *start && flags_is_blank((*end)[-1])) {
+    (*end)--;
+  }
+}
+
+/**
+ * @brief Applies one `key = value` line of a config file.
+ *
+ * Blank lines and lines starting with `#` or `;` are ignored. A key without
+ * `=` sets a boolean flag to true. The value is unquoted if it is wrapped in
+ * matching single or double quotes. Only keys found in the schema have their
+ * value terminated in place and converted.
+ *
+ * @param p The parser state.
+ * @param line Start of the line.
+ * @param end End of the line, excluding the newline; must be writable.
+ */
+static void flags_config_line(flags_parser_t *p, char *line, char *end) {
+  flags_trim(&line, &end);
+  if (line == end || *line == '#' || *line == ';') {
+    return;
+  }
+  FLAGS_STAT(p, tokens, 1);
+
+  char *eq = memchr(line, '=', (size_t)(end - line));
+  char *key_end = eq ? eq : end;
+  char *key = line;
+  flags_trim(&key, &key_end);
+
+  uint32_t idx =
+      flags_schema_find_long(p->schema, key, (size_t)(key_end - key));
+  if (!idx) {
+    FLAGS_STAT(p, unknown, 1);
+    return; // Unknown keys are skipped without converting their value.
+  }
+  FLAGS_STAT(p, long_matches, 1);
+  flag_t *flag = flags_parser_target(p, idx);
+
+  if (!eq) {
+    if (flag->type == FT_BOOL || flag->type == FT_COUNT ||
+        flags_is_null(flag)) {
+      flags_parser_mark(p, flag);
+    }
+    return;
+  }
+
+  char *v = eq + 1;
+  flags_trim(&v, &end);
+  if (end - v >= 2 && (*v == '"' || *v == '\'') && end[-1] == *v) {
+    v++;
+    end--;
+  }
+  *end = '\0';
+  flags_parser_assign(p, flag, v, (size_t)(end - v));
+}
+
+/**
+ * @brief Maps a config file and applies every line to a schema.
+ *
+ * @param schema The schema receiving the values.
+ * @param ctx Context keeping the mapping alive, or nullptr.
+ * @param path Path of the config file.
+ * @return 0 on success, or -1 with `errno` set.
+ */
+static int flags_load_config(const flag_schema_t *schema, flag_ctx_t *ctx,
+                             const char *path) {
+  flags_parser_t p;
+  flags_parser_init(&p, schema, ctx);
+  p.src = FS_CONFIG;
+  p.arg = -1;
+  uint64_t t0 = FLAGS_CLOCK(&p);
+  if (flags_schema_ready(schema) != 0) {
+    return -1;
+  }
+  FLAGS_STAT_SINCE(&p, ns_index, t0);
+
+  t0 = FLAGS_CLOCK(&p);
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int err = errno;
+    close(fd);
+    errno = err;
+    return -1;
+  }
+
+  size_t len = (size_t)st.st_size;
+  size_t map_len;
+  char *base = flags_map_file(fd, len, &map_len);
+  int err = errno;
+  close(fd);
+  if (!base) {
+    errno = err;
+    return -1;
+  }
+  FLAGS_STAT_SINCE(&p, ns_io, t0);
+
+  bool kept = flags_parser_keep_map(&p, base, map_len);
+  p.transient = !kept;
+
+  char *end = base + len;
+  for (char *line = base; line < end;) {
+    char *nl = memchr(line, '\n', (size_t)(end - line));
+    char *line_end = nl ? nl : end;
+    flags_config_line(&p, line, line_end);
+    line = line_end + 1;
+  }
+
+  if (!kept) {
+    munmap(base, map_len);
+  }
+  return flags_parser_finish(&p);
+}
+
+/**
+ * @brief Loads a `key = value` config file as a low-precedence source.
+ *
+ * @param schema The schema receiving the values.
+ * @param path Path of the config file.
+ * @return 0 on success, or -1 if an error occurs. In case of error, `errno` is
+ *         set to indicate the error.
+ */
+int hay_flags_schema_load_config(const flag_schema_t *schema,
+                                 const char *path) {
+  if (!schema || !path) {
+    errno = EINVAL;
+    return -1;
+  }
+  return flags_load_config(schema, nullptr, path);
+}
+
+/**
+ * @brief Loads a config file, keeping it mapped for the life of a context.
+ *
+ * @param ctx The context owning the mapping and copied values.
+ * @param schema The schema receiving the values.
+ * @param path Path of the config file.
+ * @return 0 on success, or -1 if an error occurs. In case of error, `errno` is
+ *         set to indicate the error.
+ */
+int hay_flags_ctx_load_config(flag_ctx_t *ctx, const flag_schema_t *schema,
+                              const char *path) {
+  if (!ctx || !schema || !path) {
+    errno = EINVAL;
+    return -1;
+  }
+  return flags_load_config(schema, ctx, path);
+}
@@ -0,0 +1,393 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Parses an unsigned decimal digit run, or a `0x` hexadecimal one if
+ *        allowed.
+ *
+ * @param s The text to parse.
+ * @param len Length of the text.
+ * @param pos Position to start at; receives the position after the digits.
+ * @param hex Whether a `0x` or `0X` prefix selects hexadecimal digits.
+ * @param out Receives the value.
+ * @return 0 on success, `EINVAL` if there is no digit, or `ERANGE` if the
+ *         value does not fit in 64 bits.
+ */
+static int flags_conv_digits(const char *s, size_t len, size_t *pos, bool hex,
+                             uint64_t *out) {
+  size_t i = *pos;
+  uint64_t v = 0;
+  unsigned base = 10;
+  if (hex && len - i > 2 && s[i] == '0' &&
+      (s[i + 1] == 'x' || s[i + 1] == 'X')) {
+    base = 16;
+    i += 2;
+  }
+
+  size_t start = i;
+  for (; i < len; i++) {
+    unsigned d = (unsigned char)s[i] - '0';
+    if (base == 16) {
+      unsigned lower = ((unsigned char)s[i] | 0x20) - 'a';
+      d = d < 10 ? d : (lower < 6 ? lower + 10 : 16);
+    }
+    if (d >= base) {
+      break;
+    }
+    if (__builtin_mul_overflow(v, base, &v) ||
+        __builtin_add_overflow(v, d, &v)) {
+      return ERANGE;
+    }
+  }
+  if (i == start) {
+    return EINVAL;
+  }
+  *pos = i;
+  *out = v;
+  return 0;
+}
+
+/**
+ * @brief Parses a signed 64-bit integer within a range.
+ *
+ * @param s The text to parse; the whole of it must be a number.
+ * @param len Length of the text.
+ * @param min Smallest accepted value.
+ * @param max Largest accepted value.
+ * @param hex Whether a `0x` prefix selects hexadecimal digits; only the
+ *            64-bit types accept one.
+ * @param out Receives the value.
+ * @return 0 on success, `EINVAL` on a format error, or `ERANGE`.
+ */
+int flags_conv_int64(const char *s, size_t len, int64_t min, int64_t max,
+                     bool hex, int64_t *out) {
+  size_t i = 0;
+  bool neg = false;
+  if (i < len && (s[i] == '-' || s[i] == '+')) {
+    neg = s[i] == '-';
+    i++;
+  }
+
+  uint64_t mag;
+  int err = flags_conv_digits(s, len, &i, hex, &mag);
+  if (err) {
+    return err;
+  }
+  if (i != len) {
+    return EINVAL; // Trailing junk, e.g. "12abc".
+  }
+
+  int64_t v;
+  if (neg) {
+    if (mag > (uint64_t)INT64_MAX + 1) {
+      return ERANGE;
+    }
+    v = mag == (uint64_t)INT64_MAX + 1 ? INT64_MIN : -(int64_t)mag;
+  } else {
+    if (mag > (uint64_t)INT64_MAX) {
+      return ERANGE;
+    }
+    v = (int64_t)mag;
+  }
+  if (v < min || v > max) {
+    return ERANGE;
+  }
+  *out = v;
+  return 0;
+}
+
+/**
+ * @brief Parses an unsigned 64-bit integer, in decimal or with a `0x` prefix.
+ *
+ * @param s The text to parse; the whole of it must be a number.
+ * @param len Length of the text.
+ * @param out Receives the value.
+ * @return 0 on success, `EINVAL` on a format error, or `ERANGE`.
+ */
+int flags_conv_uint64(const char *s, size_t len, uint64_t *out) {
+  size_t i = 0;
+  if (i < len && s[i] == '+') {
+    i++;
+  }
+  int err = flags_conv_digits(s, len, &i, true, out);
+  if (err) {
+    return err;
+  }
+  return i == len ? 0 : EINVAL;
+}
+
+#if HAY_FLAGS_MINIMAL
+/**
+ * @brief Parses a finite decimal floating-point number without strtod().
+ *
+ * Accepts `[+-]digits[.digits][(e|E)[+-]digits]`. The result is exact when
+ * the significant digits fit in 2^53 and the scale is at most 10^22 (one
+ * rounding, e.g. `0.25`, `1.5e3`, `3.14159`); beyond that it may differ from
+ * strtod() in the last bits.
+ *
+ * @param s The text to parse; the whole of it must be a number.
+ * @param len Length of the text.
+ * @param out Receives the value.
+ * @return 0 on success, `EINVAL` on a format error, or `ERANGE` on overflow
+ *         or on underflow to zero. Subnormal values are accepted.
+ */
+int flags_conv_double(const char *s, size_t len, double *out) {
+  static const double pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                 1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                 1e18, 1e19, 1e20, 1e21, 1e22};
+
+  size_t i = 0;
+  bool neg = false;
+  if (i < len && (s[i] == '+' || s[i] == '-')) {
+    neg = s[i++] == '-';
+  }
+
+  // Keep 19 significant digits; later ones only move the decimal point.
+  uint64_t mant = 0;
+  long scale = 0;
+  size_t digits = 0;
+  bool point = false;
+  for (; i < len; i++) {
+    if (s[i] == '.' && !point) {
+      point = true;
+      continue;
+    }
+    if (s[i] < '0' || s[i] > '9') {
+      break;
+    }
+    digits++;
+    if (mant < 1000000000000000000ull) {
+      mant = mant * 10 + (uint64_t)(s[i] - '0');
+      scale -= point;
+    } else {
+      scale += !point;
+    }
+  }
+  if (!digits) {
+    return EINVAL;
+  }
+
+  if (i < len && (s[i] | 0x20) == 'e') {
+    i++;
+    bool eneg = false;
+    if (i < len && (s[i] == '+' || s[i] == '-')) {
+      eneg = s[i++] == '-';
+    }
+    size_t start = i;
+    long e = 0;
+    for (; i < len && s[i] >= '0' && s[i] <= '9'; i++) {
+      if (e < 100000) {
+        e = e * 10 + (s[i] - '0');
+      }
+    }
+    if (i == start) {
+      return EINVAL;
+    }
+    scale += eneg ? -e : e;
+  }
+  if (i != len) {
+    return EINVAL;
+  }
+
+  // Past 10^±400 any significand overflows or underflows anyway.
+  scale = scale > 400 ? 400 : scale < -400 ? -400 : scale;
+  double v = (double)mant;
+  for (long e = scale; e > 0 && v != 0; e -= 22) {
+    v *= pow10[e > 22 ? 22 : e];
+  }
+  for (long e = -scale; e > 0 && v != 0; e -= 22) {
+    v /= pow10[e > 22 ? 22 : e];
+  }
+  if (!isfinite(v) || (mant && v == 0)) {
+    return ERANGE; // Overflow, or underflow past the smallest subnormal.
+  }
+  *out = neg ? -v : v;
+  return 0;
+}
+#else
+/**
+ * @brief Parses a finite floating-point number.
+ *
+ * @param s The text to parse; the whole of it must be a number.
+ * @param len Length of the text.
+ * @param out Receives the value.
+ * @return 0 on success, `EINVAL` on a format error, or `ERANGE` on overflow
+ *         or on underflow to zero. Subnormal values are accepted.
+ */
+int flags_conv_double(const char *s, size_t len, double *out) {
+  // strtod() needs a terminator and accepts leading blanks; neither applies.
+  char buf[64];
+  if (len == 0 || len >= sizeof(buf) || s[0] == ' ' || s[0] == '\t') {
+    return len >= sizeof(buf) ? ERANGE : EINVAL;
+  }
+  memcpy(buf, s, len);
+  buf[len] = '\0';
+
+  char *end;
+  int saved = errno;
+  errno = 0;
+  double v = strtod(buf, &end);
+  int err = errno;
+  errno = saved;
+  if (end != buf + len) {
+    return EINVAL;
+  }
+  // strtod() also reports ERANGE for subnormal results, which are kept; only
+  // overflow and underflow to zero are out of range.
+  if (!isfinite(v) || (err == ERANGE && v == 0)) {
+    return ERANGE;
+  }
+  *out = v;
+  return 0;
+}
+#endif
+
+/**
+ * @brief Parses a byte count with an optional binary suffix.
+ *
+ * Accepts a number followed by nothing, `B`, or one of `K`, `M`, `G`, `T`,
+ * `P`, `E` (any case, powers of 1024), optionally followed by `i` and/or `B`:
+ * `4096`, `64M`, `64MB`, `64MiB` and `1g` are all valid.
+ *
+ * @param s The text to parse.
+ * @param len Length of the text.
+ * @param out Receives the value in bytes.
+ * @return 0 on success, `EINVAL` on a format error, or `ERANGE`.
+ */
+int flags_conv_size(const char *s, size_t len, uint64_t *out) {
+  static const char units[] = "kmgtpe";
+
+  size_t i = 0;
+  uint64_t v;
+  int err = flags_conv_digits(s, len, &i, false, &v);
+  if (err) {
+    return err;
+  }
+
+  unsigned shift = 0;
+  if (i < len) {
+    const char *u = memchr(units, s[i] | 0x20, sizeof(units) - 1);
+    if (u) {
+      shift = 10 * (unsigned)(u - units + 1);
+      i++;
+      if (i < len && s[i] == 'i') {
+        i++;
+      }
+    }
+  }
+  if (i < len && (s[i] == 'B' || s[i] == 'b')) {
+    i++;
+  }
+  if (i != len) {
+    return EINVAL;
+  }
+  if (shift && v > (UINT64_MAX >> shift)) {
+    return ERANGE;
+  }
+  *out = v << shift;
+  return 0;
+}
+
+/**
+ * @brief Parses a duration made of one or more `<number><unit>` parts.
+ *
+ * Units are `ns`, `us`, `ms`, `s`, `m` and `h`, and parts add up: `250ms`,
+ * `1h30m` and `-5s` are valid. A bare number is a number of seconds.
+ *
+ * @param s The text to parse.
+ * @param len Length of the text.
+ * @param out Receives the value in nanoseconds.
+ * @return 0 on success, `EINVAL` on a format error, or `ERANGE`.
+ */
+int flags_conv_duration(const char *s, size_t len, int64_t *out) {
+  size_t i = 0;
+  bool neg = false;
+  if (i < len && (s[i] == '-' || s[i] == '+')) {
+    neg = s[i] == '-';
+    i++;
+  }
+
+  uint64_t total = 0;
+  bool first = true;
+  do {
+    uint64_t v;
+    int err = flags_conv_digits(s, len, &i, false, &v);
+    if (err) {
+      return err;
+    }
+
+    uint64_t scale;
+    size_t rest = len - i;
+    if (rest == 0 && first) {
+      scale = 1000000000ull; // A bare number is in seconds.
+    } else if (rest >= 2 && s[i] == 'n' && s[i + 1] == 's') {
+      scale = 1, i += 2;
+    } else if (rest >= 2 && s[i] == 'u' && s[i + 1] == 's') {
+      scale = 1000ull, i += 2;
+    } else if (rest >= 2 && s[i] == 'm' && s[i + 1] == 's') {
+      scale = 1000000ull, i += 2;
+    } else if (rest >= 1 && s[i] == 's') {
+      scale = 1000000000ull, i += 1;
+    } else if (rest >= 1 && s[i] == 'm') {
+      scale = 60000000000ull, i += 1;
+    } else if (rest >= 1 && s[i] == 'h') {
+      scale = 3600000000000ull, i += 1;
+    } else {
+      return EINVAL;
+    }
+
+    if (__builtin_mul_overflow(v, scale, &v) ||
+        __builtin_add_overflow(total, v, &total)) {
+      return ERANGE;
+    }
+    first = false;
+  } while (i < len);
+
+  if (total > (uint64_t)INT64_MAX) {
+    return ERANGE;
+  }
+  *out = neg ? -(int64_t)total : (int64_t)total;
+  return 0;
+}
+
+/**
+ * @brief Converts a value token for a numeric flag type.
+ *
+ * @param type The type of the flag receiving the value.
+ * @param s The text to parse.
+ * @param len Length of the text.
+ * @param out Receives the value in the member matching `type`.
+ * @return 0 on success, `EINVAL` on a format error or a non-numeric type, or
+ *         `ERANGE` if the value does not fit the type.
+ */
+int flags_convert(flag_ty_t type, const char *s, size_t len, flag_v_t *out) {
+  int err;
+  switch (type) {
+  case FT_INT: {
+    int64_t v;
+    err = flags_conv_int64(s, len, INT_MIN, INT_MAX, false, &v);
+    if (!err) {
+      out->val_int = (int)v;
+    }
+    return err;
+  }
+  case FT_INT64:
+    return flags_conv_int64(s, len, INT64_MIN, INT64_MAX, true,
+                            &out->val_int64);
+  case FT_UINT64:
+    return flags_conv_uint64(s, len, &out->val_uint64);
+  case FT_DOUBLE:
+    return flags_conv_double(s, len, &out->val_double);
+  case FT_SIZE:
+    return flags_conv_size(s, len, &out->val_size);
+  case FT_DURATION:
+    return flags_conv_duration(s, len, &out->val_duration);
+  default:
+    return EINVAL;
+  }
+}
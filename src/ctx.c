@@ -0,0 +1,267 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Size of the first arena block; later blocks double up to a limit.
+#define FLAGS_BLOCK_MIN 4096
+#define FLAGS_BLOCK_MAX (1 << 20)
+
+static void *flags_default_alloc(void *ud, size_t size) {
+  (void)ud;
+  return malloc(size);
+}
+
+static void flags_default_free(void *ud, void *ptr) {
+  (void)ud;
+  free(ptr);
+}
+
+/**
+ * @brief Creates a parse context.
+ *
+ * @param alloc Allocator hooks, or nullptr to use malloc() and free().
+ * @return Pointer to the new context, or nullptr if an error occurs. In case
+ *         of error, `errno` is set to `ENOMEM`.
+ */
+flag_ctx_t *hay_flags_ctx_create(const flag_allocator_t *alloc) {
+  flag_allocator_t hooks = {flags_default_alloc, flags_default_free, nullptr};
+  if (alloc && alloc->alloc && alloc->free) {
+    hooks = *alloc;
+  }
+
+  flag_ctx_t *ctx = hooks.alloc(hooks.ud, sizeof(flag_ctx_t));
+  if (!ctx) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  memset(ctx, 0, sizeof(flag_ctx_t));
+  ctx->alloc = hooks;
+  ctx->stats.allocs = 1;
+  return ctx;
+}
+
+/**
+ * @brief Creates a context released along with another one.
+ *
+ * @param parent The context whose destruction or reset releases the new one.
+ * @return Pointer to the new context, drawing blocks from the allocator of
+ *         the parent, or nullptr (`errno` set to `ENOMEM`).
+ */
+flag_ctx_t *flags_ctx_create_kid(flag_ctx_t *parent) {
+  flag_ctx_t *kid = hay_flags_ctx_create(&parent->alloc);
+  if (kid) {
+    kid->next = parent->kids;
+    parent->kids = kid;
+  }
+  return kid;
+}
+
+/**
+ * @brief Releases the contexts created by flags_ctx_create_kid().
+ *
+ * @param ctx Their parent.
+ */
+static void flags_ctx_release_kids(flag_ctx_t *ctx) {
+  while (ctx->kids) {
+    flag_ctx_t *kid = ctx->kids;
+    ctx->kids = kid->next;
+    hay_flags_ctx_destroy(kid);
+  }
+}
+
+/**
+ * @brief Releases a context and every block of its arena.
+ *
+ * @param ctx The context to release. May be nullptr.
+ */
+void hay_flags_ctx_destroy(flag_ctx_t *ctx) {
+  if (!ctx) {
+    return;
+  }
+  flags_ctx_release_maps(ctx);
+  flags_ctx_release_kids(ctx);
+  flag_block_t *b = ctx->head;
+  while (b) {
+    flag_block_t *next = b->next;
+    ctx->alloc.free(ctx->alloc.ud, b);
+    b = next;
+  }
+  flag_allocator_t hooks = ctx->alloc;
+  hooks.free(hooks.ud, ctx);
+}
+
+/**
+ * @brief Rewinds the arena of a context, keeping its blocks for reuse.
+ *
+ * @param ctx The context to reset.
+ */
+void hay_flags_ctx_reset(flag_ctx_t *ctx) {
+  if (!ctx) {
+    return;
+  }
+  flags_ctx_release_maps(ctx);
+  flags_ctx_release_kids(ctx);
+  for (flag_block_t *b = ctx->head; b; b = b->next) {
+    b->used = 0;
+  }
+  ctx->cur = ctx->head;
+  ctx->stats.used = 0;
+}
+
+/**
+ * @brief Reads the allocation counters of a context.
+ *
+ * @param ctx The context to inspect.
+ * @param out Receives the counters.
+ */
+void hay_flags_ctx_stats(const flag_ctx_t *ctx, flag_ctx_stats_t *out) {
+  if (ctx && out) {
+    *out = ctx->stats;
+  }
+}
+
+/**
+ * @brief Allocates memory from a context arena.
+ *
+ * Bumps the current block, moves on to the blocks kept by a previous reset,
+ * and only asks the allocator for a new block when none of them fits.
+ *
+ * @param ctx The context to allocate from.
+ * @param size Number of bytes needed.
+ * @return Memory aligned for any type, or nullptr (`errno` set to `ENOMEM`).
+ */
+void *flags_ctx_alloc(flag_ctx_t *ctx, size_t size) {
+  size = (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+
+  // Try the current block, then the blocks kept by a previous reset.
+  for (flag_block_t *b = ctx->cur; b; b = b->next) {
+    if (b->size - b->used >= size) {
+      void *ptr = b->data + b->used;
+      b->used += size;
+      ctx->cur = b;
+      ctx->stats.used += size;
+      return ptr;
+    }
+  }
+
+  size_t block_size = ctx->cur ? ctx->cur->size * 2 : FLAGS_BLOCK_MIN;
+  if (block_size > FLAGS_BLOCK_MAX) {
+    block_size = FLAGS_BLOCK_MAX;
+  }
+  if (block_size < size) {
+    block_size = size;
+  }
+
+  flag_block_t *b =
+      ctx->alloc.alloc(ctx->alloc.ud, sizeof(flag_block_t) + block_size);
+  if (!b) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  ctx->stats.allocs++;
+  ctx->stats.reserved += block_size;
+  b->size = block_size;
+  b->used = size;
+
+  // Append the block after the last one so the chain keeps its order.
+  b->next = nullptr;
+  if (!ctx->head) {
+    ctx->head = b;
+  } else {
+    flag_block_t *tail = ctx->cur;
+    while (tail->next) {
+      tail = tail->next;
+    }
+    tail->next = b;
+  }
+  ctx->cur = b;
+  ctx->stats.used += size;
+  return b->data;
+}
+
+/**
+ * @brief Copies a string of known length into a context arena.
+ *
+ * @param ctx The context to allocate from.
+ * @param s The string to copy; it does not need to be null-terminated.
+ * @param len Number of bytes to copy.
+ * @return The null-terminated copy, or nullptr (`errno` set to `ENOMEM`).
+ */
+char *flags_ctx_strndup(flag_ctx_t *ctx, const char *s, size_t len) {
+  char *copy = flags_ctx_alloc(ctx, len + 1);
+  if (copy) {
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+  }
+  return copy;
+}
+
+/**
+ * @brief Creates a flag inside a context arena.
+ *
+ * @param ctx The context owning the flag.
+ * @param name The long name of the flag.
+ * @param short_name The short name of the flag, 0 if none.
+ * @param type The type of the flag.
+ * @return Pointer to the new flag, or nullptr if an error occurs. In case of
+ *         error, `errno` is set to indicate the error.
+ */
+flag_t *hay_flags_ctx_create_flag(flag_ctx_t *ctx, const char *name,
+                                  const char short_name, flag_ty_t type) {
+  if (!ctx || !name) {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  flag_t *flag = flags_ctx_alloc(ctx, sizeof(flag_t));
+  if (!flag) {
+    return nullptr;
+  }
+  memset(flag, 0, sizeof(flag_t));
+
+  flag->name = flags_ctx_strndup(ctx, name, strlen(name));
+  if (!flag->name) {
+    return nullptr;
+  }
+  flag->short_name = short_name;
+  flag->type = type;
+  flag->opts = FO_ARENA;
+  return flag;
+}
+
+/**
+ * @brief Builds a frozen schema inside a context arena.
+ *
+ * @param ctx The context owning the schema.
+ * @param flags Array of pointers to flag_t structures, terminated by nullptr.
+ * @return Pointer to the new schema, or nullptr if an error occurs. In case
+ *         of error, `errno` is set to indicate the error.
+ */
+flag_schema_t *hay_flags_ctx_schema(flag_ctx_t *ctx, flag_t **flags) {
+  if (!ctx) {
+    errno = EINVAL;
+    return nullptr;
+  }
+  return flags_schema_build(flags, ctx);
+}
+
+/**
+ * @brief Parses command-line arguments, copying string values into a context.
+ *
+ * @param ctx The context receiving the copied values.
+ * @param schema The schema to parse against.
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line argument vector.
+ * @return 0 on success, or -1 if an error occurs. In case of error, `errno` is
+ *         set to indicate the error.
+ */
+int hay_flags_ctx_parse(flag_ctx_t *ctx, const flag_schema_t *schema, int argc,
+                        char **argv) {
+  if (!ctx || !schema || !argv) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  return flags_parse_argv(schema, ctx, argc, argv);
+}
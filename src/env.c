@@ -0,0 +1,229 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern char **environ;
+
+/**
+ * @brief Maps a character of a variable name to its place in a long name.
+ *
+ * Upper case letters are lowered and underscores become dashes, so the
+ * suffix `LOG_LEVEL` names the flag `log-level`.
+ */
+static inline char flags_env_char(char c) {
+  if (c >= 'A' && c <= 'Z') {
+    return (char)(c - 'A' + 'a');
+  }
+  return c == '_' ? '-' : c;
+}
+
+/**
+ * @brief Looks up the flag named by the suffix of a variable.
+ *
+ * Hashes and compares the suffix through flags_env_char() as it reads it, so
+ * the name is never copied.
+ *
+ * @param schema The schema to search.
+ * @param key Start of the suffix.
+ * @param len Length of the suffix in bytes.
+ * @return Index of the matching flag plus one, or 0 if there is none.
+ */
+static uint32_t flags_env_find(const flag_schema_t *schema, const char *key,
+                               size_t len) {
+  uint32_t h = 2166136261u; // flags_hash() of the mapped name.
+  for (size_t i = 0; i < len; i++) {
+    h ^= (unsigned char)flags_env_char(key[i]);
+    h *= 16777619u;
+  }
+  size_t mask = schema->cap - 1;
+  for (size_t s = h & mask;; s = (s + 1) & mask) {
+    const flag_slot_t *slot = &schema->slots[s];
+    if (!slot->idx) {
+      return 0;
+    }
+    if (slot->hash != h || slot->len != len) {
+      continue;
+    }
+    const char *name = schema->names + slot->name;
+    size_t i = 0;
+    while (i < len && name[i] == flags_env_char(key[i])) {
+      i++;
+    }
+    if (i == len) {
+      return slot->idx;
+    }
+  }
+}
+
+/**
+ * @struct flags_env_binds
+ * @brief Hash index over the variable names bound with flag_t::env.
+ */
+typedef struct flags_env_binds {
+  flag_slot_t *slots; ///< Open-addressing table; name is unused.
+  size_t cap;         ///< Number of slots (a power of two), 0 if none.
+} flags_env_binds_t;
+
+/**
+ * @brief Hashes the explicit variable names of a schema.
+ *
+ * @param schema The schema whose flags are bound.
+ * @param binds Receives the index; left empty if no flag has a name.
+ * @return 0 on success, or -1 with `errno` set (`EEXIST` if two flags are
+ *         bound to the same variable, `ENOMEM`).
+ */
+static int flags_env_bind(const flag_schema_t *schema,
+                          flags_env_binds_t *binds) {
+  size_t count = 0;
+  for (size_t i = 0; i < schema->count; i++) {
+    count += schema->flags[i]->env != nullptr;
+  }
+  *binds = (flags_env_binds_t){nullptr, 0};
+  if (!count) {
+    return 0;
+  }
+
+  size_t cap = 8;
+  while (cap < count * 2) {
+    cap <<= 1;
+  }
+  flag_slot_t *slots = calloc(cap, sizeof(flag_slot_t));
+  if (!slots) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  size_t mask = cap - 1;
+  for (size_t i = 0; i < schema->count; i++) {
+    const char *env = schema->flags[i]->env;
+    if (!env) {
+      continue;
+    }
+    uint32_t len = (uint32_t)strlen(env);
+    uint32_t h = flags_hash(env, len);
+    for (size_t s = h & mask;; s = (s + 1) & mask) {
+      if (!slots[s].idx) {
+        slots[s] = (flag_slot_t){h, (uint32_t)(i + 1), 0, len};
+        break;
+      }
+      if (slots[s].hash == h && slots[s].len == len &&
+          memcmp(schema->flags[slots[s].idx - 1]->env, env, len) == 0) {
+        free(slots);
+        errno = EEXIST; // Two flags are bound to the same variable.
+        return -1;
+      }
+    }
+  }
+  *binds = (flags_env_binds_t){slots, cap};
+  return 0;
+}
+
+/**
+ * @brief Looks up the flag bound to a variable name.
+ *
+ * @return Index of the flag plus one, or 0 if there is none.
+ */
+static uint32_t flags_env_bound(const flag_schema_t *schema,
+                                const flags_env_binds_t *binds,
+                                const char *key, size_t len) {
+  if (!binds->cap) {
+    return 0;
+  }
+  uint32_t h = flags_hash(key, len);
+  size_t mask = binds->cap - 1;
+  for (size_t s = h & mask;; s = (s + 1) & mask) {
+    const flag_slot_t *slot = &binds->slots[s];
+    if (!slot->idx) {
+      return 0;
+    }
+    if (slot->hash == h && slot->len == len &&
+        memcmp(schema->flags[slot->idx - 1]->env, key, len) == 0) {
+      return slot->idx;
+    }
+  }
+}
+
+/**
+ * @brief Applies the variables of an environment to a schema.
+ *
+ * Each variable is matched once against the explicit bindings, then, if its
+ * name starts with the prefix, against the long names. Only the variables of
+ * matching flags have their value converted.
+ *
+ * @param schema The schema receiving the values.
+ * @param prefix Prefix of the derived variable names, or nullptr.
+ * @param envp The environment, terminated by nullptr.
+ * @return 0 on success, or -1 with `errno` set.
+ */
+static int flags_load_env(const flag_schema_t *schema, const char *prefix,
+                          char *const *envp) {
+  flags_parser_t p;
+  flags_parser_init(&p, schema, nullptr);
+  p.src = FS_ENV;
+  p.arg = -1;
+  p.transient = true; // The environment may change once we return.
+  uint64_t t0 = FLAGS_CLOCK(&p);
+  flags_env_binds_t binds;
+  if (flags_schema_ready(schema) != 0 || flags_env_bind(schema, &binds) != 0) {
+    return -1;
+  }
+  FLAGS_STAT_SINCE(&p, ns_index, t0);
+
+  size_t plen = prefix ? strlen(prefix) : 0;
+  for (char *const *e = envp; *e; e++) {
+    const char *var = *e;
+    const char *eq = strchr(var, '=');
+    if (!eq) {
+      continue;
+    }
+    size_t len = (size_t)(eq - var);
+
+    uint32_t idx = flags_env_bound(schema, &binds, var, len);
+    if (!idx && prefix && len > plen && memcmp(var, prefix, plen) == 0) {
+      idx = flags_env_find(schema, var + plen, len - plen);
+      // A flag bound to a name of its own is only set through that name.
+      if (idx && schema->flags[idx - 1]->env) {
+        idx = 0;
+      }
+    } else if (!idx) {
+      continue; // Not ours: no lookup, no conversion.
+    }
+    FLAGS_STAT(&p, tokens, 1);
+    if (!idx) {
+      FLAGS_STAT(&p, unknown, 1);
+      continue;
+    }
+    FLAGS_STAT(&p, long_matches, 1);
+
+    flag_t *flag = flags_parser_target(&p, idx);
+    const char *v = eq + 1;
+    if (flags_is_null(flag)) {
+      flags_parser_mark(&p, flag);
+    } else {
+      flags_parser_assign(&p, flag, v, strlen(v));
+    }
+  }
+
+  free(binds.slots);
+  return flags_parser_finish(&p);
+}
+
+/**
+ * @brief Loads environment variables as a source below the command line.
+ *
+ * @param schema The schema receiving the values.
+ * @param prefix Prefix of the derived variable names (e.g. "MYAPP_"), or
+ *               nullptr to only use the names set in flag_t::env.
+ * @param envp The environment to read, or nullptr for `environ`.
+ * @return 0 on success, or -1 if an error occurs. In case of error, `errno` is
+ *         set to indicate the error.
+ */
+int hay_flags_schema_load_env(const flag_schema_t *schema, const char *prefix,
+                              char *const *envp) {
+  if (!schema) {
+    errno = EINVAL;
+    return -1;
+  }
+  return flags_load_env(schema, prefix, envp ? envp : environ);
+}
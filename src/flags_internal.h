@@ -0,0 +1,321 @@
+/**
+ * @file flags_internal.h
+ * @brief Internal declarations shared between the hay/flags sources.
+ *
+ * Nothing in here is part of the public API. It may change at any time.
+ */
+
+#ifndef HAY_FLAGS_INTERNAL_H
+#define HAY_FLAGS_INTERNAL_H
+
+#include <hay/flags.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <time.h>
+
+
+/**
+ * @struct flag_block
+ * @brief One block of a context arena.
+ */
+typedef struct flag_block {
+  struct flag_block *next; ///< Next block in the chain.
+  size_t size;             ///< Usable bytes in data.
+  size_t used;             ///< Bytes handed out from data.
+  alignas(max_align_t) unsigned char data[]; ///< The memory itself.
+} flag_block_t;
+
+/**
+ * @struct flag_map
+ * @brief A response file mapping kept alive by a context.
+ */
+typedef struct flag_map {
+  struct flag_map *next; ///< Next mapping of the context.
+  void *addr;            ///< Start of the mapping.
+  size_t len;            ///< Length of the mapping.
+} flag_map_t;
+
+/**
+ * @struct flag_ctx
+ * @brief A bump arena plus the allocator it draws blocks from.
+ */
+struct flag_ctx {
+  flag_allocator_t alloc; ///< Hooks used to obtain and release blocks.
+  flag_block_t *head;     ///< First block of the chain.
+  flag_block_t *cur;      ///< Block currently being bumped.
+  flag_ctx_stats_t stats; ///< Allocation counters.
+  flag_map_t *maps;       ///< Response files values may point into.
+  struct flag_ctx *kids;  ///< Contexts released along with this one.
+  struct flag_ctx *next;  ///< Next context of the same parent.
+};
+
+#ifndef HAY_FLAGS_STATS
+#define HAY_FLAGS_STATS 1
+#endif
+
+// A minimal build leaves out stdio, threads and strtod().
+#ifndef HAY_FLAGS_MINIMAL
+#define HAY_FLAGS_MINIMAL 0
+#endif
+
+/// Maximum nesting of subcommands.
+#define FLAGS_CMD_DEPTH 8
+
+/**
+ * @enum flags_args_mode_t
+ * @brief Where a parser collects the operands it meets.
+ */
+typedef enum {
+  FLAGS_ARGS_SKIP = 0, ///< Operands are skipped.
+  FLAGS_ARGS_INPLACE,  ///< Operands of argv are moved to argv[1], argv[2],
+                       ///< ... in order; argv has room since every operand
+                       ///< frees the slot it is read from.
+  FLAGS_ARGS_ARENA     ///< Operands go to an array grown in the context.
+} flags_args_mode_t;
+
+/**
+ * @struct flags_parser
+ * @brief State of a single parse, fed one token at a time.
+ */
+typedef struct flags_parser {
+  const flag_schema_t *schema;   ///< Schema tokens are dispatched against.
+  flag_ctx_t *ctx;               ///< Arena for copied values, nullptr for heap.
+  flag_t *out;                   ///< Per-parse flag copies, nullptr to write
+                                 ///< to the flags of the schema.
+  uint64_t *out_set;             ///< Bitset of the copies set so far, when
+                                 ///< out is set.
+  flag_t *pending;               ///< Flag waiting for its value, if any.
+  int pending_arg;               ///< Argument index of the pending flag.
+  flag_error_t error;            ///< First error raised, FERR_OK if none.
+  int arg;                       ///< Index of the argument being parsed.
+  unsigned depth;                ///< Nesting level of response files.
+  bool transient;                ///< Tokens die with the current mapping.
+  bool borrow;                   ///< String values point into the tokens,
+                                 ///< whatever the flags ask.
+  flag_src_t src;                ///< Source recorded on the flags it sets.
+  uint64_t gen;                  ///< Generation stamped on the flags whose
+                                 ///< value changes, 0 to not track changes.
+  size_t changed;                ///< Number of flags stamped with gen.
+  struct flags_old *olds;        ///< Lists and counts replaced by a delta.
+  flag_ctx_t *scratch;           ///< Arena of olds, nullptr until needed.
+  uint64_t stamp;                ///< Unique to the parse, recorded on the
+                                 ///< flags it sets.
+  bool rest;                     ///< Whether "--" was seen.
+  flags_args_mode_t args_mode;   ///< How operands are collected.
+  char **args;                   ///< Operands collected so far.
+  size_t nargs;                  ///< Number of operands collected.
+  size_t args_cap;               ///< Room in args (FLAGS_ARGS_ARENA only).
+  struct flags_cmd_level *level; ///< Commands the next operand may name.
+  flag_ctx_t *arena;             ///< Arena the command tree is built in.
+  const flag_cmd_t *selected;    ///< Innermost command selected so far.
+  unsigned nscopes;              ///< Number of enclosing schemas.
+  const flag_schema_t *scopes[FLAGS_CMD_DEPTH]; ///< Enclosing schemas,
+                                                ///< outermost first.
+#if HAY_FLAGS_STATS
+  flag_stats_t stats; ///< Counters reported when the parse ends.
+  bool timed;         ///< Whether clocks are read (a hook is installed).
+  uint64_t start;     ///< Clock at the start of the parse.
+  size_t ctx_allocs;  ///< Allocations of the context at the start.
+#endif
+} flags_parser_t;
+
+/**
+ * @struct flag_choices
+ * @brief The allowed values of FT_CHOICE flags and their perfect hash.
+ */
+struct flag_choices {
+  const char *const *names; ///< The choices; the ID of each is its index.
+  uint32_t count;           ///< Number of choices.
+  uint32_t seed;            ///< Seed of the hash of the names.
+  uint32_t bmask;           ///< Number of buckets minus one (a power of two).
+  uint32_t nslots;          ///< Number of slots.
+  uint8_t *slots;           ///< ID plus one of the name in each slot, 0 if
+                            ///< none.
+  uint8_t disp[];           ///< Displacement of each bucket, then the slots.
+};
+
+/// Maximum nesting of @response files.
+#define FLAGS_RESPONSE_DEPTH 8
+
+/**
+ * @brief Hashes a name of the given length (FNV-1a).
+ */
+static inline uint32_t flags_hash(const char *s, size_t len) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    h ^= (unsigned char)s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/**
+ * @brief Hashes a choice under a seed (FNV-1a, then a final mix so that the
+ *        low bits depend on every byte).
+ */
+static inline uint32_t flags_choice_hash(uint32_t seed, const char *s,
+                                         size_t len) {
+  uint32_t h = 2166136261u ^ seed;
+  for (size_t i = 0; i < len; i++) {
+    h ^= (unsigned char)s[i];
+    h *= 16777619u;
+  }
+  h ^= h >> 16;
+  h *= 0x7feb352du;
+  h ^= h >> 15;
+  return h;
+}
+
+#if HAY_FLAGS_STATS
+/**
+ * @brief Reads the monotonic clock, in nanoseconds.
+ */
+static inline uint64_t flags_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/// Adds n to a counter of the parse.
+#define FLAGS_STAT(p, field, n) ((p)->stats.field += (n))
+/// Reads the clock if the parse is timed, 0 otherwise.
+#define FLAGS_CLOCK(p) ((p)->timed ? flags_now_ns() : 0)
+/// Adds the time elapsed since t0 to a timer of the parse.
+#define FLAGS_STAT_SINCE(p, field, t0)                                         \
+  ((p)->timed ? (void)((p)->stats.field += flags_now_ns() - (t0)) : (void)0)
+#else
+#define FLAGS_STAT(p, field, n) ((void)0)
+#define FLAGS_CLOCK(p) ((uint64_t)0)
+#define FLAGS_STAT_SINCE(p, field, t0) ((void)(t0))
+#endif
+
+int flags_conv_int64(const char *s, size_t len, int64_t min, int64_t max,
+                     bool hex, int64_t *out);
+int flags_conv_uint64(const char *s, size_t len, uint64_t *out);
+int flags_conv_double(const char *s, size_t len, double *out);
+int flags_conv_size(const char *s, size_t len, uint64_t *out);
+int flags_conv_duration(const char *s, size_t len, int64_t *out);
+int flags_convert(flag_ty_t type, const char *s, size_t len, flag_v_t *out);
+int flags_choices_find(const flag_choices_t *c, const char *v, size_t len);
+
+void *flags_ctx_alloc(flag_ctx_t *ctx, size_t size);
+char *flags_ctx_strndup(flag_ctx_t *ctx, const char *s, size_t len);
+flag_ctx_t *flags_ctx_create_kid(flag_ctx_t *parent);
+
+flag_schema_t *flags_schema_build(flag_t **flags, flag_ctx_t *ctx);
+int flags_schema_index(flag_schema_t *schema);
+int flags_schema_ready(const flag_schema_t *schema);
+int flags_schema_ready_sorted(const flag_schema_t *schema);
+flag_schema_t *flags_schema_lock(const flag_schema_t *schema);
+void flags_schema_unlock(flag_schema_t *schema);
+uint32_t flags_schema_find_long(const flag_schema_t *schema, const char *name,
+                                size_t len);
+uint32_t flags_schema_find_short(const flag_schema_t *schema, char c);
+int flags_schema_sort(flag_schema_t *schema);
+uint32_t flags_schema_find_prefix(const flag_schema_t *schema,
+                                  const char *prefix, size_t len,
+                                  bool *ambiguous);
+
+/**
+ * @brief Returns the flag a parser writes to for a schema index.
+ *
+ * @param p The parser state.
+ * @param idx Index of the flag plus one, as returned by the lookups.
+ * @return The copy held by the result of the parse if there is one, the flag
+ *         of the schema otherwise.
+ */
+static inline flag_t *flags_parser_target(const flags_parser_t *p,
+                                          uint32_t idx) {
+  return p->out ? &p->out[idx - 1] : p->schema->flags[idx - 1];
+}
+
+/**
+ * @brief Whether a string value of a flag may point into its token instead
+ *        of being copied.
+ */
+static inline bool flags_parser_borrows(const flags_parser_t *p,
+                                        const flag_t *flag) {
+  if (p->transient) {
+    return false;
+  }
+  return p->borrow || (flag->opts & FO_BORROW) ||
+         (p->schema->opts & FSO_BORROW);
+}
+
+// FT_NULL is deprecated for users only; the library still handles it.
+HAY_FLAGS__DEPRECATED_PUSH
+/**
+ * @brief Returns whether a flag has the deprecated FT_NULL type.
+ */
+static inline bool flags_is_null(const flag_t *flag) {
+  return flag->type == FT_NULL;
+}
+HAY_FLAGS__DEPRECATED_POP
+
+/**
+ * @brief Returns whether a parse meets a flag for the first time.
+ *
+ * A list or count named again by a later parse replaces the previous value
+ * instead of adding to it.
+ */
+static inline bool flags_parser_first(const flags_parser_t *p,
+                                      const flag_t *flag) {
+  return flag->seen != p->stamp;
+}
+
+/**
+ * @brief Records that a parse set a flag.
+ *
+ * @param p The parser state, giving the source of the value.
+ * @param flag The flag; when the parse writes to a result, one of p->out.
+ * @param changed Whether the value differs from the one it replaced.
+ */
+static inline void flags_parser_set(flags_parser_t *p, flag_t *flag,
+                                    bool changed) {
+  if (p->gen && flag->gen != p->gen && (changed || !flag->is_set)) {
+    flag->gen = p->gen;
+    p->changed++;
+  }
+  flag->seen = p->stamp;
+  flag->is_set = true;
+  flag->src = p->src;
+  if (p->out_set) {
+    size_t i = (size_t)(flag - p->out);
+    p->out_set[i / 64] |= UINT64_C(1) << (i % 64);
+  }
+}
+
+void flags_parser_init(flags_parser_t *p, const flag_schema_t *schema,
+                       flag_ctx_t *ctx);
+void flags_parser_feed(flags_parser_t *p, const char *tok, size_t len);
+void flags_parser_fail(flags_parser_t *p, flag_err_t code, int err,
+                       flag_t *flag);
+void flags_parser_assign(flags_parser_t *p, flag_t *flag, const char *v,
+                         size_t len);
+void flags_parser_mark(flags_parser_t *p, flag_t *flag);
+flag_ctx_t *flags_list_arena(flag_ctx_t *ctx, flag_t *flag);
+void flags_list_append(flags_parser_t *p, flag_t *flag, const char *v,
+                       size_t len);
+void flags_count_bump(flags_parser_t *p, flag_t *flag);
+void flags_delta_finish(flags_parser_t *p);
+char *flags_map_file(int fd, size_t len, size_t *out_len);
+bool flags_parser_keep_map(flags_parser_t *p, void *addr, size_t len);
+void flags_parser_response(flags_parser_t *p, const char *path);
+void flags_ctx_release_maps(flag_ctx_t *ctx);
+bool flags_cmds_select(flags_parser_t *p, const char *tok, size_t len);
+void flags_parser_run(flags_parser_t *p, int argc, char **argv);
+int flags_parser_finish(flags_parser_t *p);
+
+#if HAY_FLAGS_STATS
+void flags_stats_begin(flags_parser_t *p);
+void flags_stats_end(flags_parser_t *p);
+#else
+static inline void flags_stats_begin(flags_parser_t *p) { (void)p; }
+static inline void flags_stats_end(flags_parser_t *p) { (void)p; }
+#endif
+int flags_parse_argv(const flag_schema_t *schema, flag_ctx_t *ctx, int argc,
+                     char **argv);
+flag_result_t *flags_result_capture(const flag_schema_t *schema);
+flag_t *flags_result_at(flag_result_t *res, uint32_t idx);
+
+#endif // HAY_FLAGS_INTERNAL_H
@@ -0,0 +1,271 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/// Widest left column; longer names push their description to a new line.
+#define FLAGS_HELP_COL_MAX 32
+
+/**
+ * @brief Returns the value placeholder shown after a long name.
+ */
+static const char *flags_help_placeholder(flag_ty_t type) {
+  switch (type) {
+  case FT_STR:
+    return " <str>";
+  case FT_INT:
+  case FT_INT64:
+    return " <int>";
+  case FT_UINT64:
+    return " <uint>";
+  case FT_DOUBLE:
+    return " <num>";
+  case FT_SIZE:
+    return " <size>";
+  case FT_DURATION:
+    return " <duration>";
+  case FT_STR_LIST:
+    return " <str>...";
+  case FT_INT_LIST:
+    return " <int>...";
+  case FT_CHOICE:
+    return " <choice>";
+  default:
+    return "";
+  }
+}
+
+/**
+ * @brief Returns the length of the placeholder of a flag.
+ *
+ * An FT_CHOICE flag lists its choices instead, e.g. " <fast|safe|debug>".
+ */
+static size_t flags_help_value_len(const flag_t *flag) {
+  const flag_choices_t *c = flag->choices;
+  if (flag->type != FT_CHOICE || !c) {
+    return strlen(flags_help_placeholder(flag->type));
+  }
+  size_t len = 2 + c->count; // " <", the separators and ">".
+  for (uint32_t i = 0; i < c->count; i++) {
+    len += strlen(c->names[i]);
+  }
+  return len;
+}
+
+/**
+ * @brief Returns the width of the names part of the line of a flag.
+ */
+static size_t flags_help_left(const flag_t *flag) {
+  // "  -p, --" or "      --", then the name and the placeholder.
+  return 8 + strlen(flag->name) + flags_help_value_len(flag);
+}
+
+/**
+ * @brief Returns the length of the description part of the line of a flag.
+ */
+static size_t flags_help_right(const flag_t *flag) {
+  size_t len = flag->desc ? strlen(flag->desc) : 0;
+  if (flag->defval) {
+    len += (flag->desc ? 1 : 0) + sizeof("(default: )") - 1 +
+           strlen(flag->defval);
+  }
+  return len;
+}
+
+/**
+ * @brief Appends bytes to the buffer being rendered.
+ */
+static inline char *flags_put(char *w, const char *s, size_t len) {
+  memcpy(w, s, len);
+  return w + len;
+}
+
+/**
+ * @brief Appends the placeholder of a flag to the buffer being rendered.
+ */
+static char *flags_help_value(char *w, const flag_t *flag) {
+  const flag_choices_t *c = flag->choices;
+  if (flag->type != FT_CHOICE || !c) {
+    const char *ph = flags_help_placeholder(flag->type);
+    return flags_put(w, ph, strlen(ph));
+  }
+  w = flags_put(w, " <", 2);
+  for (uint32_t i = 0; i < c->count; i++) {
+    if (i) {
+      *w++ = '|';
+    }
+    w = flags_put(w, c->names[i], strlen(c->names[i]));
+  }
+  *w++ = '>';
+  return w;
+}
+
+/**
+ * @brief Renders the help of a schema into a single buffer.
+ *
+ * Two passes over the flags: one to size the columns and the buffer, one to
+ * fill it. No formatting function is involved.
+ *
+ * @param schema The schema to describe.
+ * @param out_len Receives the length of the text.
+ * @return The text, allocated like the schema, or nullptr (`errno` set to
+ *         `ENOMEM`).
+ */
+static char *flags_help_render(const flag_schema_t *schema, size_t *out_len) {
+  size_t col = 0;
+  for (size_t i = 0; i < schema->count; i++) {
+    size_t left = flags_help_left(schema->flags[i]);
+    if (left > col && left <= FLAGS_HELP_COL_MAX) {
+      col = left;
+    }
+  }
+  col += 2; // Gap between the names and the descriptions.
+
+  size_t size = 0;
+  for (size_t i = 0; i < schema->count; i++) {
+    const flag_t *flag = schema->flags[i];
+    size_t left = flags_help_left(flag);
+    size_t right = flags_help_right(flag);
+    size += left + 1;
+    if (right) {
+      size += (left + 2 > col ? 1 + col : col - left) + right;
+    }
+  }
+
+  char *buf = schema->ctx ? flags_ctx_alloc(schema->ctx, size + 1)
+                          : malloc(size + 1);
+  if (!buf) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+
+  char *w = buf;
+  for (size_t i = 0; i < schema->count; i++) {
+    const flag_t *flag = schema->flags[i];
+    if (flag->short_name) {
+      w = flags_put(w, "  -", 3);
+      *w++ = flag->short_name;
+      w = flags_put(w, ", --", 4);
+    } else {
+      w = flags_put(w, "      --", 8);
+    }
+    w = flags_put(w, flag->name, strlen(flag->name));
+    w = flags_help_value(w, flag);
+
+    if (flags_help_right(flag)) {
+      size_t left = flags_help_left(flag);
+      size_t pad = col - left;
+      if (left + 2 > col) {
+        *w++ = '\n'; // Too wide: the description goes on its own line.
+        pad = col;
+      }
+      memset(w, ' ', pad);
+      w += pad;
+      if (flag->desc) {
+        w = flags_put(w, flag->desc, strlen(flag->desc));
+      }
+      if (flag->defval) {
+        if (flag->desc) {
+          *w++ = ' ';
+        }
+        w = flags_put(w, "(default: ", 10);
+        w = flags_put(w, flag->defval, strlen(flag->defval));
+        *w++ = ')';
+      }
+    }
+    *w++ = '\n';
+  }
+  *w = '\0';
+  *out_len = (size_t)(w - buf);
+  return buf;
+}
+
+/**
+ * @brief Returns the help text of a schema, rendering it on first use.
+ *
+ * @param schema The schema to describe.
+ * @return The text, or a view with a nullptr ptr if an error occurs. In case
+ *         of error, `errno` is set to indicate the error.
+ */
+flag_view_t hay_flags_help(const flag_schema_t *schema) {
+  if (!schema) {
+    errno = EINVAL;
+    return (flag_view_t){nullptr, 0};
+  }
+  if (!__atomic_load_n(&schema->help, __ATOMIC_ACQUIRE)) {
+    // The cache is not part of what the schema means, like its index.
+    flag_schema_t *cache = flags_schema_lock(schema);
+    if (!cache->help) {
+      size_t len;
+      char *help = flags_help_render(schema, &len);
+      if (!help) {
+        flags_schema_unlock(cache);
+        return (flag_view_t){nullptr, 0};
+      }
+      cache->help_len = len;
+      __atomic_store_n(&cache->help, help, __ATOMIC_RELEASE);
+    }
+    flags_schema_unlock(cache);
+  }
+  return (flag_view_t){schema->help, schema->help_len};
+}
+
+/**
+ * @brief Writes bytes to a file descriptor, retrying after partial writes.
+ *
+ * @return 0 on success, or -1 with `errno` set.
+ */
+static int flags_write_all(int fd, const char *s, size_t len) {
+  while (len) {
+    ssize_t w = write(fd, s, len);
+    if (w < 0 && errno != EINTR) {
+      return -1;
+    }
+    if (w > 0) {
+      s += w;
+      len -= (size_t)w;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Writes a usage line and the help of a schema with one writev().
+ *
+ * @param schema The schema to describe.
+ * @param fd The file descriptor to write to.
+ * @param usage Text written before the help, or nullptr.
+ * @return 0 on success, or -1 if an error occurs. In case of error, `errno` is
+ *         set to indicate the error.
+ */
+int hay_flags_print_help(const flag_schema_t *schema, int fd,
+                         const char *usage) {
+  flag_view_t help = hay_flags_help(schema);
+  if (!help.ptr) {
+    return -1;
+  }
+
+  struct iovec iov[2];
+  int n = 0;
+  if (usage && *usage) {
+    iov[n++] = (struct iovec){(void *)usage, strlen(usage)};
+  }
+  iov[n++] = (struct iovec){(void *)help.ptr, help.len};
+
+  ssize_t done = writev(fd, iov, n);
+  if (done < 0) {
+    return -1;
+  }
+  // Finish a short write (e.g. to a pipe) from where it stopped.
+  for (int i = 0; i < n; i++) {
+    size_t skip = (size_t)done < iov[i].iov_len ? (size_t)done : iov[i].iov_len;
+    done -= (ssize_t)skip;
+    if (flags_write_all(fd, (const char *)iov[i].iov_base + skip,
+                        iov[i].iov_len - skip) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
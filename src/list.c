@@ -0,0 +1,247 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+
+/// Number of items a list holds before its first growth.
+#define FLAGS_LIST_MIN 8
+
+/**
+ * @brief Returns the arena the items of a list flag are allocated from.
+ *
+ * A parse with a context uses that context. Without one, the flag gets an
+ * arena of its own, released by hay_flags_destroy(); a flag that has one
+ * keeps using it, so its items never mix heap and context storage.
+ *
+ * @param ctx The context of the parse, or nullptr.
+ * @param flag The list flag.
+ * @return The arena, or nullptr (`errno` set to `ENOMEM`).
+ */
+flag_ctx_t *flags_list_arena(flag_ctx_t *ctx, flag_t *flag) {
+  flag_list_t *l = &flag->val.val_list;
+  if (ctx && !(flag->opts & FO_OWNED)) {
+    return ctx;
+  }
+  if (!l->own) {
+    l->own = hay_flags_ctx_create(nullptr);
+    if (!l->own) {
+      return nullptr;
+    }
+    flag->opts |= FO_OWNED;
+  }
+  return l->own;
+}
+
+/**
+ * @brief Reserves room for one more item at the end of a list flag.
+ *
+ * The capacity doubles whenever the list is full, so appending n items costs
+ * O(n) copies and O(log n) allocations in total.
+ *
+ * @param p The parser state, used to record errors.
+ * @param flag The list flag.
+ * @param size Size of one item.
+ * @return The new item, or nullptr on allocation failure (recorded in p).
+ */
+static void *flags_list_push(flags_parser_t *p, flag_t *flag, size_t size) {
+  flag_list_t *l = &flag->val.val_list;
+  if (l->len == l->cap) {
+    flag_ctx_t *arena = flags_list_arena(p->ctx, flag);
+    size_t cap = l->cap ? l->cap * 2 : FLAGS_LIST_MIN;
+    size_t allocs = arena ? arena->stats.allocs : 0;
+    void *items = arena ? flags_ctx_alloc(arena, cap * size) : nullptr;
+    if (arena && arena != p->ctx) {
+      FLAGS_STAT(p, allocs, arena->stats.allocs - allocs);
+    }
+    if (!items) {
+      flags_parser_fail(p, FERR_NOMEM, ENOMEM, flag);
+      return nullptr;
+    }
+    if (l->len) {
+      memcpy(items, l->items, l->len * size);
+    }
+    l->items = items;
+    l->cap = cap;
+  }
+  return (char *)l->items + l->len++ * size;
+}
+
+/**
+ * @struct flags_old
+ * @brief The value a delta replaced in a list or count flag.
+ */
+typedef struct flags_old {
+  struct flags_old *next; ///< Next flag replaced by the same delta.
+  flag_t *flag;           ///< The flag.
+  flag_v_t val;           ///< Its value; list items are copied to scratch.
+} flags_old_t;
+
+/**
+ * @brief Keeps the value of a list or count flag that a delta replaces.
+ *
+ * A delta rebuilds these flags item by item, so whether it changed them is
+ * only known once it is applied. A flag that was not set is a change anyway,
+ * and so is one whose value could not be kept.
+ *
+ * @param p The parser state; nothing is kept unless it tracks changes.
+ * @param flag The list or count flag, met for the first time by the parse.
+ */
+static void flags_delta_keep(flags_parser_t *p, flag_t *flag) {
+  if (!p->gen || !flag->is_set) {
+    return;
+  }
+  if (!p->scratch) {
+    p->scratch = hay_flags_ctx_create(nullptr);
+  }
+  flags_old_t *old =
+      p->scratch ? flags_ctx_alloc(p->scratch, sizeof(flags_old_t)) : nullptr;
+  if (old) {
+    *old = (flags_old_t){p->olds, flag, flag->val};
+    const flag_list_t *l = &flag->val.val_list;
+    if (flag->type == FT_INT_LIST && l->len) {
+      size_t size = l->len * sizeof(int64_t);
+      old->val.val_list.items = flags_ctx_alloc(p->scratch, size);
+      if (old->val.val_list.items) {
+        memcpy(old->val.val_list.items, l->items, size);
+      }
+    } else if (flag->type == FT_STR_LIST && l->len) {
+      const flag_view_t *src = l->items;
+      flag_view_t *dst =
+          flags_ctx_alloc(p->scratch, l->len * sizeof(flag_view_t));
+      for (size_t i = 0; dst && i < l->len; i++) {
+        dst[i].len = src[i].len;
+        dst[i].ptr = flags_ctx_strndup(p->scratch, src[i].ptr, src[i].len);
+        if (!dst[i].ptr) {
+          dst = nullptr;
+        }
+      }
+      old->val.val_list.items = dst;
+    }
+    if (flag->type == FT_COUNT || !l->len || old->val.val_list.items) {
+      p->olds = old;
+      return;
+    }
+  }
+  flag->gen = p->gen; // Out of memory: report a change rather than none.
+  p->changed++;
+}
+
+/**
+ * @brief Returns whether a list or count flag differs from a kept value.
+ */
+static bool flags_delta_differs(const flag_t *flag, const flag_v_t *old) {
+  if (flag->type == FT_COUNT) {
+    return flag->val.val_count != old->val_count;
+  }
+  const flag_list_t *a = &old->val_list;
+  const flag_list_t *b = &flag->val.val_list;
+  if (a->len != b->len) {
+    return true;
+  }
+  if (flag->type == FT_INT_LIST) {
+    return a->len && memcmp(a->items, b->items, a->len * sizeof(int64_t));
+  }
+  const flag_view_t *x = a->items;
+  const flag_view_t *y = b->items;
+  for (size_t i = 0; i < a->len; i++) {
+    if (x[i].len != y[i].len || memcmp(x[i].ptr, y[i].ptr, x[i].len) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Stamps the lists and counts a delta actually changed.
+ *
+ * Releases the values kept by flags_delta_keep().
+ *
+ * @param p The parser state, once the delta is applied.
+ */
+void flags_delta_finish(flags_parser_t *p) {
+  for (flags_old_t *old = p->olds; old; old = old->next) {
+    flag_t *flag = old->flag;
+    if (flag->gen != p->gen && flags_delta_differs(flag, &old->val)) {
+      flag->gen = p->gen;
+      p->changed++;
+    }
+  }
+  p->olds = nullptr;
+  hay_flags_ctx_destroy(p->scratch);
+  p->scratch = nullptr;
+}
+
+/**
+ * @brief Appends a value token to a list flag.
+ *
+ * Items accumulate within one parse. The first item of a later parse
+ * replaces them instead, so a list given on the command line replaces the
+ * one from a config file and a parse repeated with the same schema gives the
+ * same list. The items of an arena owned by the flag are then released, and
+ * the items of any other storage are left untouched.
+ *
+ * @param p The parser state.
+ * @param flag The FT_STR_LIST or FT_INT_LIST flag.
+ * @param v The value token (null-terminated).
+ * @param len Length of the value token in bytes.
+ */
+void flags_list_append(flags_parser_t *p, flag_t *flag, const char *v,
+                       size_t len) {
+  flag_list_t *l = &flag->val.val_list;
+  if (flags_parser_first(p, flag)) {
+    flags_delta_keep(p, flag);
+    // Items the flag does not own may be read-only, as those of a mapped
+    // snapshot are, so the list starts over in fresh storage.
+    if (l->own) {
+      hay_flags_ctx_reset(l->own);
+    }
+    l->items = nullptr;
+    l->len = l->cap = 0;
+  }
+
+  if (flag->type == FT_INT_LIST) {
+    int64_t n;
+    int err = flags_conv_int64(v, len, INT64_MIN, INT64_MAX, false, &n);
+    if (err) {
+      flags_parser_fail(p, err == ERANGE ? FERR_RANGE : FERR_FORMAT, err, flag);
+      return;
+    }
+    int64_t *item = flags_list_push(p, flag, sizeof(int64_t));
+    if (item) {
+      *item = n;
+    }
+  } else {
+    const char *str = v;
+    if (!flags_parser_borrows(p, flag)) {
+      flag_ctx_t *arena = flags_list_arena(p->ctx, flag);
+      str = arena ? flags_ctx_strndup(arena, v, len) : nullptr;
+      if (!str) {
+        flags_parser_fail(p, FERR_NOMEM, ENOMEM, flag);
+        return;
+      }
+    }
+    flag_view_t *item = flags_list_push(p, flag, sizeof(flag_view_t));
+    if (item) {
+      *item = (flag_view_t){str, len};
+    }
+  }
+  flags_parser_set(p, flag, false); // Compared by flags_delta_finish().
+}
+
+/**
+ * @brief Counts one more occurrence of an FT_COUNT flag.
+ *
+ * The first occurrence in a parse restarts the count from zero.
+ *
+ * @param p The parser state, giving the source of the flag.
+ * @param flag The FT_COUNT flag.
+ */
+void flags_count_bump(flags_parser_t *p, flag_t *flag) {
+  if (flags_parser_first(p, flag)) {
+    flags_delta_keep(p, flag);
+    flag->val.val_count = 0;
+  }
+  if (flag->val.val_count < UINT_MAX) {
+    flag->val.val_count++;
+  }
+}
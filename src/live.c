@@ -0,0 +1,295 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Size of a cache line, so that readers never share one.
+#define FLAGS_CACHE_LINE 64
+/// Entries of the lookup cache of a reader (a power of two).
+#define FLAGS_READER_CACHE 8
+
+/**
+ * @struct flags_live_ver
+ * @brief One published version of the values of a schema.
+ */
+typedef struct flags_live_ver {
+  flag_result_t *res;          ///< Frozen copy of the values.
+  uint64_t gen;                ///< Generation of the schema when copied.
+  uint64_t retired;            ///< Epoch it was replaced in, 0 if current.
+  struct flags_live_ver *next; ///< Next retired version.
+} flags_live_ver_t;
+
+/**
+ * @struct flag_reader
+ * @brief The slot of one reader thread.
+ *
+ * Aligned on a cache line: entering and leaving write only to the slot of the
+ * reader, so readers never contend with one another.
+ */
+struct flag_reader {
+  /// Epoch announced on entry, 0 outside of a read section.
+  alignas(FLAGS_CACHE_LINE) atomic_uint_fast64_t epoch;
+  atomic_bool used;         ///< Whether a thread holds the slot.
+  flags_live_ver_t *ver;    ///< Version pinned by the reader.
+  flag_live_t *live;        ///< Owner of the slot.
+  struct flag_reader *next; ///< Next slot of the owner.
+  struct {
+    const flag_t *flag; ///< Flag looked up, nullptr if the entry is empty.
+    const char *name;   ///< Its long name, when it was looked up.
+    uint32_t idx;       ///< Its index in the schema.
+  } cache[FLAGS_READER_CACHE]; ///< Recent lookups, by address of the flag.
+};
+
+/**
+ * @struct flag_live
+ * @brief Versions of the values of a schema, read without locks.
+ */
+struct flag_live {
+  const flag_schema_t *schema;      ///< Schema the versions are copied from.
+  _Atomic(flags_live_ver_t *) cur;  ///< Current version.
+  atomic_uint_fast64_t epoch;       ///< Bumped by every publish.
+  _Atomic(flag_reader_t *) readers; ///< Every slot ever handed out.
+  flags_live_ver_t *retired;        ///< Replaced versions not yet freed.
+};
+
+/**
+ * @brief Captures the current values of a schema into a new version.
+ *
+ * @return The version, or nullptr with `errno` set.
+ */
+static flags_live_ver_t *flags_live_capture(const flag_schema_t *schema) {
+  flags_live_ver_t *ver = malloc(sizeof(flags_live_ver_t));
+  if (!ver) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  ver->res = flags_result_capture(schema);
+  if (!ver->res) {
+    free(ver);
+    return nullptr;
+  }
+  ver->gen = schema->gen;
+  ver->retired = 0;
+  ver->next = nullptr;
+  return ver;
+}
+
+/**
+ * @brief Releases a version and its values.
+ */
+static void flags_live_free(flags_live_ver_t *ver) {
+  hay_flags_result_destroy(ver->res);
+  free(ver);
+}
+
+/**
+ * @brief Frees the retired versions no reader can still hold.
+ *
+ * A version retired in epoch e can only be held by a reader that entered
+ * before e, and such a reader announces an epoch below e until it leaves.
+ *
+ * @param live The owner of the versions.
+ */
+static void flags_live_reclaim(flag_live_t *live) {
+  uint64_t oldest = UINT64_MAX;
+  for (flag_reader_t *r = atomic_load(&live->readers); r; r = r->next) {
+    uint64_t e = atomic_load(&r->epoch);
+    if (e && e < oldest) {
+      oldest = e;
+    }
+  }
+
+  flags_live_ver_t **link = &live->retired;
+  while (*link) {
+    flags_live_ver_t *ver = *link;
+    if (ver->retired <= oldest) {
+      *link = ver->next;
+      flags_live_free(ver);
+    } else {
+      link = &ver->next;
+    }
+  }
+}
+
+/**
+ * @brief Creates versioned values for a schema and publishes its current
+ *        values.
+ *
+ * @param schema The schema whose values are published.
+ * @return Pointer to the new object, or nullptr if an error occurs. In case
+ *         of error, `errno` is set to indicate the error.
+ */
+flag_live_t *hay_flags_live_create(const flag_schema_t *schema) {
+  if (!schema) {
+    errno = EINVAL;
+    return nullptr;
+  }
+  flag_live_t *live = malloc(sizeof(flag_live_t));
+  if (!live) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  flags_live_ver_t *ver = flags_live_capture(schema);
+  if (!ver) {
+    free(live);
+    return nullptr;
+  }
+  live->schema = schema;
+  atomic_init(&live->cur, ver);
+  atomic_init(&live->epoch, 1);
+  atomic_init(&live->readers, nullptr);
+  live->retired = nullptr;
+  return live;
+}
+
+/**
+ * @brief Releases versioned values, every version and every reader slot.
+ *
+ * @param live The object to release. May be nullptr.
+ */
+void hay_flags_live_destroy(flag_live_t *live) {
+  if (!live) {
+    return;
+  }
+  flag_reader_t *r = atomic_load(&live->readers);
+  while (r) {
+    flag_reader_t *next = r->next;
+    free(r);
+    r = next;
+  }
+  while (live->retired) {
+    flags_live_ver_t *next = live->retired->next;
+    flags_live_free(live->retired);
+    live->retired = next;
+  }
+  flags_live_free(atomic_load(&live->cur));
+  free(live);
+}
+
+/**
+ * @brief Publishes the current values of the schema as a new version.
+ *
+ * @param live The object to publish to.
+ * @return 0 on success, or -1 if an error occurs. In case of error, `errno` is
+ *         set to indicate the error.
+ */
+int hay_flags_live_publish(flag_live_t *live) {
+  if (!live) {
+    errno = EINVAL;
+    return -1;
+  }
+  flags_live_ver_t *ver = flags_live_capture(live->schema);
+  if (!ver) {
+    return -1;
+  }
+
+  // Swap first: a reader announcing the new epoch loads the new version.
+  flags_live_ver_t *old = atomic_exchange(&live->cur, ver);
+  old->retired = atomic_fetch_add(&live->epoch, 1) + 1;
+  old->next = live->retired;
+  live->retired = old;
+  flags_live_reclaim(live);
+  return 0;
+}
+
+/**
+ * @brief Hands out a reader slot, reusing a released one if possible.
+ *
+ * @param live The object to read.
+ * @return The slot, or nullptr if an error occurs. In case of error, `errno`
+ *         is set to indicate the error.
+ */
+flag_reader_t *hay_flags_live_reader(flag_live_t *live) {
+  if (!live) {
+    errno = EINVAL;
+    return nullptr;
+  }
+  for (flag_reader_t *r = atomic_load(&live->readers); r; r = r->next) {
+    bool free_slot = false;
+    if (atomic_compare_exchange_strong(&r->used, &free_slot, true)) {
+      return r;
+    }
+  }
+
+  flag_reader_t *r = aligned_alloc(FLAGS_CACHE_LINE, sizeof(flag_reader_t));
+  if (!r) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  atomic_init(&r->epoch, 0);
+  atomic_init(&r->used, true);
+  memset(r->cache, 0, sizeof(r->cache));
+  r->ver = nullptr;
+  r->live = live;
+  r->next = atomic_load(&live->readers);
+  while (!atomic_compare_exchange_weak(&live->readers, &r->next, r)) {
+  }
+  return r;
+}
+
+/**
+ * @brief Gives a reader slot back for another thread to use.
+ *
+ * @param reader The slot, outside of any read section. May be nullptr.
+ */
+void hay_flags_live_reader_release(flag_reader_t *reader) {
+  if (reader) {
+    reader->ver = nullptr;
+    atomic_store_explicit(&reader->used, false, memory_order_release);
+  }
+}
+
+/**
+ * @brief Enters a read section and pins the current version.
+ *
+ * @param reader The slot of the calling thread.
+ * @return The generation of the schema the pinned version was copied at.
+ */
+uint64_t hay_flags_live_enter(flag_reader_t *reader) {
+  flag_live_t *live = reader->live;
+  // Announce the epoch before loading the version, so that a writer either
+  // sees the announcement or has already swapped in the version we load.
+  atomic_store(&reader->epoch, atomic_load(&live->epoch));
+  reader->ver = atomic_load(&live->cur);
+  return reader->ver->gen;
+}
+
+/**
+ * @brief Returns the copy of a flag in the version pinned by a reader.
+ *
+ * Every version has the layout of the schema, so the index of a flag is
+ * looked up by name once and then cached in the slot of the reader, keyed by
+ * the address of the flag and checked against its name pointer.
+ *
+ * @param reader The slot of the calling thread, inside a read section.
+ * @param flag The flag to look up, by its long name.
+ * @return The copy, or nullptr if the schema has no such flag.
+ */
+flag_t *hay_flags_live_get(flag_reader_t *reader, const flag_t *flag) {
+  if (!flag || !flag->name) {
+    return nullptr;
+  }
+  size_t h = ((uintptr_t)flag / sizeof(flag_t)) & (FLAGS_READER_CACHE - 1);
+  if (reader->cache[h].flag != flag || reader->cache[h].name != flag->name) {
+    uint32_t idx = flags_schema_find_long(reader->live->schema, flag->name,
+                                          strlen(flag->name));
+    if (!idx) {
+      return nullptr;
+    }
+    reader->cache[h].flag = flag;
+    reader->cache[h].name = flag->name;
+    reader->cache[h].idx = idx - 1;
+  }
+  return flags_result_at(reader->ver->res, reader->cache[h].idx);
+}
+
+/**
+ * @brief Leaves a read section; the pinned version may then be freed.
+ *
+ * @param reader The slot of the calling thread.
+ */
+void hay_flags_live_exit(flag_reader_t *reader) {
+  reader->ver = nullptr;
+  atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+}
@@ -0,0 +1,581 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Returns whether two values of a scalar type are the same.
+ */
+static bool flags_same_scalar(flag_ty_t type, const flag_v_t *a,
+                              const flag_v_t *b) {
+  switch (type) {
+  case FT_INT:
+    return a->val_int == b->val_int;
+  case FT_INT64:
+    return a->val_int64 == b->val_int64;
+  case FT_UINT64:
+    return a->val_uint64 == b->val_uint64;
+  case FT_DOUBLE:
+    // Bitwise, so that a NaN is the same as itself.
+    return memcmp(&a->val_double, &b->val_double, sizeof(double)) == 0;
+  case FT_SIZE:
+    return a->val_size == b->val_size;
+  case FT_DURATION:
+    return a->val_duration == b->val_duration;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief Stores a value token into a flag, according to its type.
+ *
+ * Values from a source of lower precedence than the one that last set the
+ * flag are ignored, so argv wins over a config file whatever the load order.
+ *
+ * @param p The parser state, used to record errors.
+ * @param flag The flag receiving the value.
+ * @param v The value token (null-terminated).
+ * @param len Length of the value token in bytes.
+ */
+void flags_parser_assign(flags_parser_t *p, flag_t *flag, const char *v,
+                         size_t len) {
+  if (p->src < flag->src) {
+    return;
+  }
+
+  bool changed;
+  switch (flag->type) {
+  case FT_STR: {
+    flag_view_t old = flag->val.val_view;
+    changed = old.len != len || !old.ptr || memcmp(old.ptr, v, len) != 0;
+    const char *str = v;
+    if (!flags_parser_borrows(p, flag)) {
+      str = p->ctx ? flags_ctx_strndup(p->ctx, v, len) : strndup(v, len);
+      if (!p->ctx) {
+        FLAGS_STAT(p, allocs, 1);
+      }
+      if (!str) {
+        flags_parser_fail(p, FERR_NOMEM, ENOMEM, flag);
+        return;
+      }
+    }
+    // Release the previous heap copy instead of leaking it.
+    if (flag->opts & FO_OWNED) {
+      free((char *)flag->val.val_str);
+    }
+    flag->val.val_view = (flag_view_t){str, len};
+    if (str == v || p->ctx) {
+      flag->opts &= ~FO_OWNED;
+    } else {
+      flag->opts |= FO_OWNED;
+    }
+    break;
+  }
+  case FT_STR_LIST:
+  case FT_INT_LIST:
+    flags_list_append(p, flag, v, len);
+    return;
+  case FT_COUNT: {
+    // An explicit count, e.g. "verbose = 3" in a config file.
+    int64_t n;
+    int err = flags_conv_int64(v, len, 0, UINT_MAX, false, &n);
+    if (err) {
+      flags_parser_fail(p, err == ERANGE ? FERR_RANGE : FERR_FORMAT, err, flag);
+      return;
+    }
+    changed = flag->val.val_count != (unsigned)n;
+    flag->val.val_count = (unsigned)n;
+    break;
+  }
+  case FT_CHOICE: {
+    int id = flag->choices ? flags_choices_find(flag->choices, v, len) : -1;
+    if (id < 0) {
+      // The flag keeps its previous value.
+      flags_parser_fail(p, FERR_CHOICE, EINVAL, flag);
+      return;
+    }
+    changed = flag->val.val_choice != (unsigned)id;
+    flag->val.val_choice = (unsigned)id;
+    break;
+  }
+  case FT_BOOL: {
+    bool b = true; // Default to true for unknown values.
+    if (strcmp(v, "false") == 0 || strcmp(v, "0") == 0) {
+      b = false;
+    }
+    changed = flag->val.val_bool != b;
+    flag->val.val_bool = b;
+    break;
+  }
+  default: {
+    flag_v_t val;
+    int err = flags_convert(flag->type, v, len, &val);
+    if (err) {
+      // The flag keeps its previous value.
+      flags_parser_fail(p, err == ERANGE ? FERR_RANGE : FERR_FORMAT, err, flag);
+      return;
+    }
+    changed = !flags_same_scalar(flag->type, &flag->val, &val);
+    flag->val = val;
+    break;
+  }
+  }
+  flags_parser_set(p, flag, changed);
+}
+
+/**
+ * @brief Marks a flag that takes no value as present.
+ *
+ * @param p The parser state, giving the source of the flag.
+ * @param flag The FT_BOOL, FT_COUNT or FT_NULL flag.
+ */
+void flags_parser_mark(flags_parser_t *p, flag_t *flag) {
+  if (p->src < flag->src) {
+    return;
+  }
+  bool changed = false;
+  if (flag->type == FT_BOOL) {
+    changed = !flag->val.val_bool;
+    flag->val.val_bool = true; // Treat --flag as --flag true
+  } else if (flag->type == FT_COUNT) {
+    flags_count_bump(p, flag); // Compared by flags_delta_finish().
+  }
+  flags_parser_set(p, flag, changed);
+}
+
+/**
+ * @brief Returns whether a flag of this type consumes the next token.
+ */
+static inline bool flags_takes_value(const flag_t *flag) {
+  return flag->type != FT_BOOL && flag->type != FT_COUNT &&
+         !flags_is_null(flag);
+}
+
+/**
+ * @brief Prepares a parser for a new run against a schema.
+ *
+ * @param p The parser state to initialise.
+ * @param schema The frozen schema tokens are dispatched against.
+ * @param ctx Arena receiving copied values, or nullptr for the heap.
+ */
+void flags_parser_init(flags_parser_t *p, const flag_schema_t *schema,
+                       flag_ctx_t *ctx) {
+  static atomic_uint_fast64_t stamps = 0;
+  p->schema = schema;
+  p->ctx = ctx;
+  p->out = nullptr;
+  p->out_set = nullptr;
+  p->pending = nullptr;
+  p->error = (flag_error_t){FERR_OK, 0, -1, nullptr};
+  p->pending_arg = 0;
+  p->arg = 0;
+  p->depth = 0;
+  p->transient = false;
+  p->borrow = false;
+  p->src = FS_ARGV;
+  p->gen = 0;
+  p->changed = 0;
+  p->olds = nullptr;
+  p->scratch = nullptr;
+  p->stamp = atomic_fetch_add_explicit(&stamps, 1, memory_order_relaxed) + 1;
+  p->level = nullptr;
+  p->arena = nullptr;
+  p->selected = nullptr;
+  p->nscopes = 0;
+  p->rest = false;
+  p->args_mode = FLAGS_ARGS_SKIP;
+  p->args = nullptr;
+  p->nargs = 0;
+  p->args_cap = 0;
+  flags_stats_begin(p);
+}
+
+/**
+ * @brief Records an error, keeping the first one raised.
+ *
+ * @param p The parser state; the current argument index is recorded too.
+ * @param code The kind of error.
+ * @param err The matching errno value, reported by the errno-based API.
+ * @param flag The flag the error is about, or nullptr.
+ */
+void flags_parser_fail(flags_parser_t *p, flag_err_t code, int err,
+                       flag_t *flag) {
+  if (code == FERR_FORMAT || code == FERR_RANGE) {
+    FLAGS_STAT(p, conv_failures, 1);
+  }
+  if (!p->error.code) {
+    p->error = (flag_error_t){code, err, p->arg, flag};
+  }
+}
+
+/**
+ * @brief Looks up a long name in the schema of a parser, then in the schemas
+ *        of the commands enclosing it.
+ *
+ * Exact names are tried first in every schema. Only then is the name taken as
+ * an abbreviation, in the schemas with FSO_ABBREV, in the same order; an
+ * abbreviation matching several names of a schema is an error.
+ *
+ * @param p The parser state.
+ * @param name Start of the name; it does not need to be null-terminated.
+ * @param len Length of the name in bytes.
+ * @return The flag to write to, or nullptr if there is none.
+ */
+static flag_t *flags_parser_find_long(flags_parser_t *p, const char *name,
+                                      size_t len) {
+  uint32_t idx = flags_schema_find_long(p->schema, name, len);
+  if (idx) {
+    return flags_parser_target(p, idx);
+  }
+  for (unsigned i = p->nscopes; i-- > 0;) {
+    const flag_schema_t *scope = p->scopes[i];
+    idx = flags_schema_find_long(scope, name, len);
+    if (idx) {
+      return scope->flags[idx - 1];
+    }
+  }
+
+  bool ambiguous = false;
+  if (p->schema->opts & FSO_ABBREV) {
+    idx = flags_schema_find_prefix(p->schema, name, len, &ambiguous);
+    if (idx) {
+      return flags_parser_target(p, idx);
+    }
+  }
+  for (unsigned i = p->nscopes; i-- > 0 && !ambiguous;) {
+    const flag_schema_t *scope = p->scopes[i];
+    if (scope->opts & FSO_ABBREV) {
+      idx = flags_schema_find_prefix(scope, name, len, &ambiguous);
+      if (idx) {
+        return scope->flags[idx - 1];
+      }
+    }
+  }
+  if (ambiguous) {
+    flags_parser_fail(p, FERR_AMBIGUOUS, EINVAL, nullptr);
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Looks up a short name like flags_parser_find_long().
+ *
+ * @param p The parser state.
+ * @param c The short name.
+ * @return The flag to write to, or nullptr if there is none.
+ */
+static flag_t *flags_parser_find_short(const flags_parser_t *p, char c) {
+  uint32_t idx = flags_schema_find_short(p->schema, c);
+  if (idx) {
+    return flags_parser_target(p, idx);
+  }
+  for (unsigned i = p->nscopes; i-- > 0;) {
+    const flag_schema_t *scope = p->scopes[i];
+    idx = flags_schema_find_short(scope, c);
+    if (idx) {
+      return scope->flags[idx - 1];
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Collects an operand, according to the mode of the parser.
+ *
+ * Operands are never copied, except those of a response file whose mapping
+ * dies with the parse.
+ *
+ * @param p The parser state.
+ * @param tok The operand, null-terminated.
+ * @param len Length of the operand in bytes.
+ */
+static void flags_parser_operand(flags_parser_t *p, const char *tok,
+                                 size_t len) {
+  if (p->args_mode == FLAGS_ARGS_INPLACE) {
+    if (p->depth == 0) {
+      p->args[p->nargs++] = (char *)tok;
+    }
+    return;
+  }
+  if (p->args_mode != FLAGS_ARGS_ARENA) {
+    return;
+  }
+
+  if (p->nargs == p->args_cap) {
+    size_t cap = p->args_cap ? p->args_cap * 2 : 16;
+    char **args = flags_ctx_alloc(p->ctx, cap * sizeof(char *));
+    if (!args) {
+      flags_parser_fail(p, FERR_NOMEM, ENOMEM, nullptr);
+      return;
+    }
+    if (p->nargs) {
+      memcpy(args, p->args, p->nargs * sizeof(char *));
+    }
+    p->args = args;
+    p->args_cap = cap;
+  }
+  char *arg = (char *)tok;
+  if (p->transient) {
+    arg = flags_ctx_strndup(p->ctx, tok, len);
+    if (!arg) {
+      flags_parser_fail(p, FERR_NOMEM, ENOMEM, nullptr);
+      return;
+    }
+  }
+  p->args[p->nargs++] = arg;
+}
+
+/**
+ * @brief Feeds one token to the parser.
+ *
+ * Each token is classified once: a value for the pending flag, a long option
+ * with an optional `=value` (hash lookup), a bundle of short options with an
+ * optional attached value (table lookup per character), a
+ * response file when the schema enables them, a subcommand when parsing
+ * through a command tree, or an operand. After `--`, every token is an
+ * operand.
+ *
+ * @param p The parser state.
+ * @param tok The token, null-terminated.
+ * @param len Length of the token in bytes.
+ */
+void flags_parser_feed(flags_parser_t *p, const char *tok, size_t len) {
+  FLAGS_STAT(p, tokens, 1);
+  if (p->pending) {
+    flag_t *flag = p->pending;
+    p->pending = nullptr;
+    flags_parser_assign(p, flag, tok, len);
+    return;
+  }
+
+  if (p->rest) {
+    flags_parser_operand(p, tok, len);
+    return;
+  }
+  if (len == 2 && tok[0] == '-' && tok[1] == '-') {
+    p->rest = true; // "--" ends the options.
+    return;
+  }
+
+  if (tok[0] == '@' && len > 1 && (p->schema->opts & FSO_RESPONSE_FILES)) {
+    flags_parser_response(p, tok + 1);
+    return;
+  }
+
+  if (len < 2 || tok[0] != '-') {
+    // Operands and a lone "-" are not flags.
+    if (!p->level || !flags_cmds_select(p, tok, len)) {
+      flags_parser_operand(p, tok, len);
+    }
+    return;
+  }
+
+  if (tok[1] == '-') {
+    // Long option (e.g., --verbose or --port=3000). The name is looked up by
+    // its length, so the key is never copied or terminated.
+    const char *name = tok + 2;
+    const char *eq = memchr(name, '=', len - 2);
+    size_t name_len = eq ? (size_t)(eq - name) : len - 2;
+    flag_t *flag = flags_parser_find_long(p, name, name_len);
+    if (!flag) {
+      FLAGS_STAT(p, unknown, 1);
+      return;
+    }
+    FLAGS_STAT(p, long_matches, 1);
+    if (eq && !flags_is_null(flag)) {
+      flags_parser_assign(p, flag, eq + 1, len - name_len - 3);
+    } else if (!eq && flags_takes_value(flag)) {
+      p->pending = flag;
+      p->pending_arg = p->arg;
+    } else {
+      flags_parser_mark(p, flag);
+    }
+    return;
+  }
+
+  // Short options, possibly bundled (e.g., -v, -Vr, -p 3000, -p3000 or
+  // -Vp3000). The first flag taking a value ends the bundle: the rest of the
+  // token is its value, or the next token if nothing is left.
+  for (size_t k = 1; k < len; k++) {
+    flag_t *flag = flags_parser_find_short(p, tok[k]);
+    if (!flag) {
+      FLAGS_STAT(p, unknown, 1);
+      continue;
+    }
+    FLAGS_STAT(p, short_matches, 1);
+    if (!flags_takes_value(flag)) {
+      flags_parser_mark(p, flag);
+    } else if (k + 1 < len) {
+      flags_parser_assign(p, flag, tok + k + 1, len - k - 1);
+      return;
+    } else {
+      p->pending = flag;
+      p->pending_arg = p->arg;
+    }
+  }
+}
+
+/**
+ * @brief Ends a parse.
+ *
+ * A flag still waiting for its value is left unset and reported as
+ * FERR_MISSING.
+ *
+ * @param p The parser state.
+ * @return 0 on success, or -1 with `errno` set if an error was recorded.
+ */
+int flags_parser_finish(flags_parser_t *p) {
+  if (p->pending) {
+    p->arg = p->pending_arg;
+    flags_parser_fail(p, FERR_MISSING, EINVAL, p->pending);
+    FLAGS_STAT(p, missing, 1);
+    p->pending = nullptr;
+  }
+  flags_stats_end(p);
+  if (p->error.code) {
+    errno = p->error.errnum;
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Feeds every argument of a vector, except the program name.
+ *
+ * @param p The parser state.
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line argument vector.
+ */
+void flags_parser_run(flags_parser_t *p, int argc, char **argv) {
+  for (p->arg = 1; p->arg < argc; p->arg++) {
+    const char *tok = argv[p->arg];
+    if (!tok) {
+      continue; // Skip null arguments.
+    }
+    flags_parser_feed(p, tok, strlen(tok));
+  }
+}
+
+/**
+ * @brief Feeds an argument vector through a parser.
+ *
+ * @param schema The schema to parse against.
+ * @param ctx Arena receiving copied values, or nullptr for the heap.
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line argument vector.
+ * @return 0 on success, or -1 with `errno` set.
+ */
+int flags_parse_argv(const flag_schema_t *schema, flag_ctx_t *ctx, int argc,
+                     char **argv) {
+  flags_parser_t p;
+  flags_parser_init(&p, schema, ctx);
+  uint64_t t0 = FLAGS_CLOCK(&p);
+  if (flags_schema_ready(schema) != 0) {
+    return -1;
+  }
+  FLAGS_STAT_SINCE(&p, ns_index, t0);
+  flags_parser_run(&p, argc, argv);
+  return flags_parser_finish(&p);
+}
+
+/**
+ * @brief Parses command-line arguments, compacting the operands into argv.
+ *
+ * @param schema The schema to parse against.
+ * @param argc Points to the number of command-line arguments; receives the
+ *             program name plus the number of operands.
+ * @param argv The command-line argument vector.
+ * @return 0 on success, or -1 if an error occurs. In case of error, `errno` is
+ *         set to indicate the error.
+ */
+int hay_flags_schema_parse_args(const flag_schema_t *schema, int *argc,
+                                char **argv) {
+  if (!schema || !argc || !argv || *argc < 1) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  flags_parser_t p;
+  flags_parser_init(&p, schema, nullptr);
+  if (flags_schema_ready(schema) != 0) {
+    return -1;
+  }
+  p.args_mode = FLAGS_ARGS_INPLACE;
+  p.args = argv + 1;
+  flags_parser_run(&p, *argc, argv);
+  *argc = 1 + (int)p.nargs;
+  argv[*argc] = nullptr;
+  return flags_parser_finish(&p);
+}
+
+/**
+ * @brief Parses command-line arguments against a frozen schema.
+ *
+ * Every argument is classified exactly once and dispatched in constant time,
+ * so the cost is linear in `argc` regardless of the number of flags. The
+ * schema can be reused for any number of parses.
+ *
+ * @param schema The schema built by hay_flags_schema_create().
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line argument vector.
+ * @return 0 on success, or -1 if an error occurs. In case of error, `errno` is
+ *         set to indicate the error.
+ */
+int hay_flags_schema_parse(const flag_schema_t *schema, int argc, char **argv) {
+  if (!schema || !argv) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  return flags_parse_argv(schema, nullptr, argc, argv);
+}
+
+/**
+ * @brief Applies a fragment of arguments to the flags of a schema.
+ *
+ * @param schema The schema whose flags receive the values.
+ * @param argc The number of arguments in the fragment.
+ * @param argv The fragment; argv[0] is an argument, not a program name.
+ * @return The number of flags whose value changed, or -1 if an error occurs.
+ *         In case of error, `errno` is set to indicate the error.
+ */
+long hay_flags_schema_apply(flag_schema_t *schema, int argc, char **argv) {
+  if (!schema || (argc && !argv)) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  flags_parser_t p;
+  flags_parser_init(&p, schema, nullptr);
+  if (flags_schema_ready(schema) != 0) {
+    return -1;
+  }
+  p.gen = schema->gen + 1;
+  for (p.arg = 0; p.arg < argc; p.arg++) {
+    if (argv[p.arg]) {
+      flags_parser_feed(&p, argv[p.arg], strlen(argv[p.arg]));
+    }
+  }
+  flags_delta_finish(&p);
+  // Flags changed before an error keep their value, so count them anyway.
+  if (p.changed) {
+    schema->gen = p.gen;
+  }
+  if (flags_parser_finish(&p) != 0) {
+    return -1;
+  }
+  return (long)p.changed;
+}
+
+/**
+ * @brief Returns the generation of a schema.
+ *
+ * @param schema The schema to read.
+ * @return The generation, 0 if no delta changed a flag of the schema yet.
+ */
+uint64_t hay_flags_schema_gen(const flag_schema_t *schema) {
+  return schema ? schema->gen : 0;
+}
@@ -0,0 +1,148 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Orders two entries of a sorted index by name.
+ */
+static int flags_sorted_cmp(const void *a, const void *b) {
+  return strcmp(((const flag_sorted_t *)a)->name,
+                ((const flag_sorted_t *)b)->name);
+}
+
+/**
+ * @brief Builds the sorted index over the long names of a schema.
+ *
+ * The index is allocated like the schema: in its context, or on the heap and
+ * released by hay_flags_schema_destroy(). Schemas declared with
+ * HAY_FLAGS_STATIC() keep theirs for the life of the process.
+ *
+ * @param schema The schema to index.
+ * @return 0 on success, or -1 with `errno` set to `ENOMEM`.
+ */
+int flags_schema_sort(flag_schema_t *schema) {
+  size_t size = (schema->count ? schema->count : 1) * sizeof(flag_sorted_t);
+  flag_sorted_t *sorted =
+      schema->ctx ? flags_ctx_alloc(schema->ctx, size) : malloc(size);
+  if (!sorted) {
+    errno = ENOMEM;
+    return -1;
+  }
+  for (size_t i = 0; i < schema->count; i++) {
+    sorted[i] = (flag_sorted_t){schema->flags[i]->name, (uint32_t)(i + 1)};
+  }
+  qsort(sorted, schema->count, sizeof(flag_sorted_t), flags_sorted_cmp);
+  __atomic_store_n(&schema->sorted, sorted, __ATOMIC_RELEASE);
+  return 0;
+}
+
+/**
+ * @brief Returns the first entry of a sorted index not ordered before a
+ *        prefix, or past it.
+ *
+ * @param sorted The index.
+ * @param count Number of entries.
+ * @param prefix The prefix; it does not need to be null-terminated.
+ * @param len Length of the prefix in bytes.
+ * @param past false to skip the names ordered before the prefix, true to also
+ *             skip those starting with it.
+ * @return Position of the entry, or count if there is none.
+ */
+static size_t flags_sorted_bound(const flag_sorted_t *sorted, size_t count,
+                                 const char *prefix, size_t len, bool past) {
+  size_t lo = 0, hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int cmp = strncmp(sorted[mid].name, prefix, len);
+    if (cmp < 0 || (past && cmp == 0)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/**
+ * @brief Locates the range of the sorted index whose names start with a
+ *        prefix.
+ *
+ * @param schema The schema to search; its sorted index must be built.
+ * @param prefix The prefix; it does not need to be null-terminated.
+ * @param len Length of the prefix in bytes.
+ * @param first Receives the position of the first match.
+ * @return The number of matches.
+ */
+static size_t flags_schema_prefix_range(const flag_schema_t *schema,
+                                        const char *prefix, size_t len,
+                                        size_t *first) {
+  size_t lo =
+      flags_sorted_bound(schema->sorted, schema->count, prefix, len, false);
+  size_t hi = flags_sorted_bound(schema->sorted + lo, schema->count - lo,
+                                 prefix, len, true);
+  *first = lo;
+  return hi;
+}
+
+/**
+ * @brief Looks up a flag by an abbreviation of its long name.
+ *
+ * @param schema The schema to search.
+ * @param prefix Start of the abbreviation; it does not need to be
+ *               null-terminated.
+ * @param len Length of the abbreviation in bytes.
+ * @param ambiguous Set to true if several names start with the abbreviation.
+ * @return Index of the only matching flag plus one, or 0 if there is none,
+ *         the abbreviation is ambiguous or empty, or the sorted index of the
+ *         schema is not built.
+ */
+uint32_t flags_schema_find_prefix(const flag_schema_t *schema,
+                                  const char *prefix, size_t len,
+                                  bool *ambiguous) {
+  if (len == 0) {
+    return 0; // "--=value" abbreviates nothing.
+  }
+  if (!__atomic_load_n(&schema->sorted, __ATOMIC_ACQUIRE)) {
+    return 0; // Options changed since the schema was made ready.
+  }
+  size_t first;
+  size_t n = flags_schema_prefix_range(schema, prefix, len, &first);
+  if (n > 1) {
+    *ambiguous = true;
+  }
+  return n == 1 ? schema->sorted[first].idx : 0;
+}
+
+/**
+ * @brief Lists the flags whose long name starts with a prefix.
+ *
+ * @param schema The schema to search.
+ * @param word The word being completed, with or without its leading `--`.
+ * @param out Receives up to `max` matching flags, in the order of their names.
+ * @param max The capacity of `out`.
+ * @return The number of matching flags, which may exceed `max`, or -1 if an
+ *         error occurs. In case of error, `errno` is set to indicate the
+ *         error.
+ */
+long hay_flags_complete(const flag_schema_t *schema, const char *word,
+                        const flag_t **out, size_t max) {
+  if (!schema || !word || (max && !out)) {
+    errno = EINVAL;
+    return -1;
+  }
+  // The index is a cache over the names, like the hash table.
+  if (flags_schema_ready_sorted(schema) != 0) {
+    return -1;
+  }
+
+  if (word[0] == '-' && word[1] == '-') {
+    word += 2;
+  }
+  size_t first;
+  size_t n = flags_schema_prefix_range(schema, word, strlen(word), &first);
+  for (size_t i = 0; i < n && i < max; i++) {
+    out[i] = schema->flags[schema->sorted[first + i].idx - 1];
+  }
+  return (long)n;
+}
@@ -0,0 +1,199 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Returns whether a character separates response file tokens.
+ */
+static inline bool flags_is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' ||
+         c == '\f';
+}
+
+/**
+ * @brief Maps a file privately, with one writable byte past its end.
+ *
+ * The tokenizer terminates every token in place, including one that ends
+ * exactly at end of file. When the file size is a multiple of the page size
+ * that byte would fall outside the file mapping, so an anonymous region one
+ * byte larger is reserved first and the file is mapped over it.
+ *
+ * @param fd The file to map.
+ * @param len Size of the file.
+ * @param out_len Receives the length of the whole mapping.
+ * @return The start of the mapping, or nullptr with `errno` set.
+ */
+char *flags_map_file(int fd, size_t len, size_t *out_len) {
+  *out_len = len + 1;
+  char *base = mmap(nullptr, *out_len, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    return nullptr;
+  }
+  if (len && mmap(base, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+                  fd, 0) == MAP_FAILED) {
+    int err = errno;
+    munmap(base, *out_len);
+    errno = err;
+    return nullptr;
+  }
+  return base;
+}
+
+/**
+ * @brief Splits a mapped response file into tokens and feeds each of them.
+ *
+ * Tokens are separated by whitespace. Single quotes preserve everything up to
+ * the closing quote; inside double quotes a backslash escapes `"` and `\`;
+ * outside quotes a backslash escapes any character. Unescaping is done in
+ * place, so tokens are slices of the mapping and nothing is copied.
+ *
+ * @param p The parser state.
+ * @param r Start of the file contents.
+ * @param end One past the last byte of the file; must be writable.
+ */
+static void flags_tokenize(flags_parser_t *p, char *r, char *end) {
+  while (r < end) {
+    while (r < end && flags_is_space(*r)) {
+      r++;
+    }
+    if (r == end) {
+      break;
+    }
+
+    char *start = r;
+    char *w = r;
+    char quote = 0;
+    while (r < end) {
+      char c = *r;
+      if (quote) {
+        if (c == quote) {
+          quote = 0;
+          r++;
+        } else if (quote == '"' && c == '\\' && r + 1 < end &&
+                   (r[1] == '"' || r[1] == '\\')) {
+          *w++ = r[1];
+          r += 2;
+        } else {
+          *w++ = c;
+          r++;
+        }
+        continue;
+      }
+      if (flags_is_space(c)) {
+        break;
+      }
+      if (c == '"' || c == '\'') {
+        quote = c;
+        r++;
+      } else if (c == '\\' && r + 1 < end) {
+        *w++ = r[1];
+        r += 2;
+      } else {
+        *w++ = c;
+        r++;
+      }
+    }
+
+    // w never passes r, so the terminator lands on the separator at worst.
+    *w = '\0';
+    if (r < end) {
+      r++;
+    }
+    flags_parser_feed(p, start, (size_t)(w - start));
+  }
+}
+
+/**
+ * @brief Expands a response file into the token stream of a parser.
+ *
+ * The file is mapped with mmap() and tokenized in place. Its tokens go through
+ * flags_parser_feed() exactly like arguments from argv, so a flag in argv may
+ * take its value from the file and vice versa. When the parse has a context,
+ * the mapping is kept until the context is reset or destroyed, and borrowed
+ * values point into it. Otherwise it is unmapped once the file is consumed
+ * and string values taken from it are copied.
+ *
+ * @param p The parser state. Errors are recorded in it: FERR_DEPTH when
+ *          files nest deeper than FLAGS_RESPONSE_DEPTH, or FERR_IO with the
+ *          errno value of a failed open(), fstat() or mmap().
+ * @param path Path of the response file, null-terminated.
+ */
+void flags_parser_response(flags_parser_t *p, const char *path) {
+  if (p->depth >= FLAGS_RESPONSE_DEPTH) {
+    flags_parser_fail(p, FERR_DEPTH, ELOOP, nullptr);
+    return;
+  }
+
+  uint64_t t0 = FLAGS_CLOCK(p);
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    flags_parser_fail(p, FERR_IO, errno, nullptr);
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    flags_parser_fail(p, FERR_IO, errno, nullptr);
+    close(fd);
+    return;
+  }
+
+  size_t len = (size_t)st.st_size;
+  size_t map_len;
+  char *base = flags_map_file(fd, len, &map_len);
+  close(fd);
+  FLAGS_STAT_SINCE(p, ns_io, t0);
+  if (!base) {
+    flags_parser_fail(p, FERR_IO, errno, nullptr);
+    return;
+  }
+
+  bool kept = flags_parser_keep_map(p, base, map_len);
+  bool transient = p->transient;
+  p->transient = transient || !kept;
+  p->depth++;
+  flags_tokenize(p, base, base + len);
+  p->depth--;
+  p->transient = transient;
+
+  if (!kept) {
+    munmap(base, map_len);
+  }
+}
+
+/**
+ * @brief Hands a file mapping over to the context of a parse, if any.
+ *
+ * @param p The parser state.
+ * @param addr Start of the mapping.
+ * @param len Length of the mapping.
+ * @return true if the context now owns the mapping, false if the caller must
+ *         unmap it (and copy any value taken from it).
+ */
+bool flags_parser_keep_map(flags_parser_t *p, void *addr, size_t len) {
+  if (!p->ctx) {
+    return false;
+  }
+  flag_map_t *map = flags_ctx_alloc(p->ctx, sizeof(flag_map_t));
+  if (!map) {
+    return false;
+  }
+  *map = (flag_map_t){p->ctx->maps, addr, len};
+  p->ctx->maps = map;
+  return true;
+}
+
+/**
+ * @brief Unmaps every response file kept alive by a context.
+ *
+ * @param ctx The context being reset or destroyed.
+ */
+void flags_ctx_release_maps(flag_ctx_t *ctx) {
+  for (flag_map_t *m = ctx->maps; m; m = m->next) {
+    munmap(m->addr, m->len);
+  }
+  ctx->maps = nullptr;
+}
@@ -0,0 +1,723 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if !HAY_FLAGS_MINIMAL
+#include <pthread.h>
+#endif
+
+/// Upper bound on the threads of a batch parse, the caller included.
+#define FLAGS_BATCH_THREADS 64
+
+/**
+ * @struct flag_result
+ * @brief Per-parse copies of the flags of a schema.
+ *
+ * The copies are one dense array in schema order, followed in the same block
+ * by a bitset of those the last parse set, so resetting and listing the set
+ * flags never touches the others.
+ */
+struct flag_result {
+  const flag_schema_t *schema; ///< The schema parsed against.
+  flag_ctx_t *ctx;             ///< Arena for copied values and mappings.
+  flag_error_t error;          ///< First error of the last parse.
+  char **args;                 ///< Operands of the last parse.
+  size_t nargs;                ///< Number of operands.
+  uint64_t *set;               ///< One bit per copy, set by the last parse.
+  flag_t flags[];              ///< One copy per flag of the schema.
+};
+
+/// Number of 64-bit words of the bitset of a result.
+#define FLAGS_SET_WORDS(count) (((count) + 63) / 64)
+
+/**
+ * @brief Returns a static description of an error code.
+ *
+ * @param code The error code.
+ * @return A string that must not be modified or freed.
+ */
+const char *hay_flags_strerror(flag_err_t code) {
+  switch (code) {
+  case FERR_OK:
+    return "success";
+  case FERR_ARGS:
+    return "invalid arguments";
+  case FERR_NOMEM:
+    return "out of memory";
+  case FERR_FORMAT:
+    return "invalid value";
+  case FERR_RANGE:
+    return "value out of range";
+  case FERR_MISSING:
+    return "missing value";
+  case FERR_IO:
+    return "cannot read response file";
+  case FERR_DEPTH:
+    return "response files nested too deeply";
+  case FERR_AMBIGUOUS:
+    return "ambiguous abbreviation";
+  case FERR_CHOICE:
+    return "invalid choice";
+  case FERR_CMD_DEPTH:
+    return "commands nested too deeply";
+  }
+  return "unknown error";
+}
+
+/**
+ * @brief Creates a result bound to a schema.
+ *
+ * @param schema The schema the result is parsed against.
+ * @return Pointer to the new result, or nullptr if an error occurs. In case
+ *         of error, `errno` is set to indicate the error.
+ */
+flag_result_t *hay_flags_result_create(const flag_schema_t *schema) {
+  if (!schema) {
+    errno = EINVAL;
+    return nullptr;
+  }
+  if (flags_schema_ready(schema) != 0) {
+    return nullptr;
+  }
+
+  size_t words = FLAGS_SET_WORDS(schema->count);
+  flag_result_t *res = malloc(sizeof(flag_result_t) +
+                              schema->count * sizeof(flag_t) +
+                              words * sizeof(uint64_t));
+  if (!res) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  res->ctx = hay_flags_ctx_create(nullptr);
+  if (!res->ctx) {
+    free(res);
+    return nullptr;
+  }
+  res->schema = schema;
+  res->error = (flag_error_t){FERR_OK, 0, -1, nullptr};
+  res->args = nullptr;
+  res->nargs = 0;
+  res->set = (uint64_t *)&res->flags[schema->count];
+  memset(res->set, 0, words * sizeof(uint64_t));
+
+  // Copy the definitions only; values are cleared before every parse.
+  for (size_t i = 0; i < schema->count; i++) {
+    const flag_t *def = schema->flags[i];
+    res->flags[i] = (flag_t){
+        .name = def->name,
+        .short_name = def->short_name,
+        .type = def->type,
+        .opts = def->opts & ~(unsigned)(FO_OWNED | FO_ARENA),
+        .desc = def->desc,
+        .defval = def->defval,
+        .env = def->env,
+        .choices = def->choices,
+    };
+  }
+  return res;
+}
+
+/**
+ * @brief Copies a value of a flag into the arena of a result.
+ *
+ * Strings and list items are duplicated, so the copy does not depend on the
+ * storage of the original.
+ *
+ * @return 0 on success, or -1 with `errno` set to `ENOMEM`.
+ */
+static int flags_result_copy(flag_ctx_t *ctx, flag_t *dst, const flag_t *src) {
+  dst->val = src->val;
+  if (src->type == FT_STR && src->val.val_view.ptr) {
+    flag_view_t v = src->val.val_view;
+    dst->val.val_view.ptr = flags_ctx_strndup(ctx, v.ptr, v.len);
+    return dst->val.val_view.ptr ? 0 : -1;
+  }
+  if (src->type != FT_STR_LIST && src->type != FT_INT_LIST) {
+    return 0;
+  }
+
+  const flag_list_t *l = &src->val.val_list;
+  size_t size =
+      src->type == FT_STR_LIST ? sizeof(flag_view_t) : sizeof(int64_t);
+  void *items = l->len ? flags_ctx_alloc(ctx, l->len * size) : nullptr;
+  if (l->len && !items) {
+    return -1;
+  }
+  if (l->len) {
+    memcpy(items, l->items, l->len * size);
+  }
+  dst->val.val_list = (flag_list_t){items, l->len, l->len, nullptr};
+  if (src->type == FT_STR_LIST) {
+    flag_view_t *views = items;
+    for (size_t i = 0; i < l->len; i++) {
+      views[i].ptr = flags_ctx_strndup(ctx, views[i].ptr, views[i].len);
+      if (!views[i].ptr) {
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Creates a result holding a copy of the current values of a schema.
+ *
+ * The copy owns every string and list item it holds, so it stays valid and
+ * unchanged however the flags of the schema change afterwards.
+ *
+ * @param schema The schema to copy.
+ * @return The result, or nullptr with `errno` set.
+ */
+flag_result_t *flags_result_capture(const flag_schema_t *schema) {
+  flag_result_t *res = hay_flags_result_create(schema);
+  if (!res) {
+    return nullptr;
+  }
+  for (size_t i = 0; i < schema->count; i++) {
+    const flag_t *src = schema->flags[i];
+    if (!src->is_set) {
+      continue;
+    }
+    flag_t *dst = &res->flags[i];
+    if (flags_result_copy(res->ctx, dst, src) != 0) {
+      hay_flags_result_destroy(res);
+      errno = ENOMEM;
+      return nullptr;
+    }
+    dst->is_set = true;
+    dst->src = src->src;
+    dst->gen = src->gen;
+    res->set[i / 64] |= UINT64_C(1) << (i % 64);
+  }
+  return res;
+}
+
+/**
+ * @brief Releases a result and every value copied into it.
+ *
+ * @param res The result to release. May be nullptr.
+ */
+void hay_flags_result_destroy(flag_result_t *res) {
+  if (!res) {
+    return;
+  }
+  hay_flags_ctx_destroy(res->ctx);
+  free(res);
+}
+
+/**
+ * @brief Clears a result and starts a parse into it.
+ *
+ * The schema is made ready first, as options such as FSO_ABBREV may have
+ * been set since the result was created.
+ *
+ * @param res The result receiving the values.
+ * @param p The parser state to initialise.
+ * @return true if the parse can run, or false with the error recorded in p.
+ */
+static bool flags_result_begin(flag_result_t *res, flags_parser_t *p) {
+  // Only the flags set by the previous parse hold a value.
+  hay_flags_ctx_reset(res->ctx);
+  size_t i = 0;
+  while (hay_flags_result_next(res, &i)) {
+    flag_t *flag = &res->flags[i - 1];
+    flag->val = (flag_v_t){0};
+    flag->is_set = false;
+    flag->src = FS_UNSET;
+  }
+  memset(res->set, 0, FLAGS_SET_WORDS(res->schema->count) * sizeof(uint64_t));
+
+  flags_parser_init(p, res->schema, res->ctx);
+  p->out = res->flags;
+  p->out_set = res->set;
+  p->args_mode = FLAGS_ARGS_ARENA;
+  if (flags_schema_ready(res->schema) != 0) {
+    int err = errno;
+    flags_parser_fail(p, err == ENOMEM ? FERR_NOMEM : FERR_ARGS, err, nullptr);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Ends a parse into a result and keeps its error and operands.
+ *
+ * @param res The result receiving the values.
+ * @param p The parser state.
+ * @return FERR_OK on success, or the code of the first error.
+ */
+static flag_err_t flags_result_end(flag_result_t *res, flags_parser_t *p) {
+  if (p->pending) {
+    p->arg = p->pending_arg;
+    flags_parser_fail(p, FERR_MISSING, EINVAL, p->pending);
+    FLAGS_STAT(p, missing, 1);
+  }
+  flags_stats_end(p);
+  res->error = p->error;
+  res->args = p->args;
+  res->nargs = p->nargs;
+  return p->error.code;
+}
+
+/**
+ * @brief Parses command-line arguments into a result.
+ *
+ * @param res The result receiving the values.
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line argument vector.
+ * @return FERR_OK on success, or the code of the first error.
+ */
+flag_err_t hay_flags_parse_r(flag_result_t *res, int argc, char **argv) {
+  if (!res) {
+    return FERR_ARGS;
+  }
+  if (!argv) {
+    res->error = (flag_error_t){FERR_ARGS, EINVAL, -1, nullptr};
+    res->args = nullptr;
+    res->nargs = 0;
+    return FERR_ARGS;
+  }
+
+  flags_parser_t p;
+  if (flags_result_begin(res, &p)) {
+    flags_parser_run(&p, argc, argv);
+  }
+  return flags_result_end(res, &p);
+}
+
+/**
+ * @brief Parses a NUL-separated argument blob into a result.
+ *
+ * Every token but the last is already terminated by its separator, so it is
+ * fed to the parser where it lies, and string values are views into the
+ * blob whatever the flags ask. Only a last token missing its terminator is
+ * copied, into the arena of the result.
+ *
+ * @param res The result receiving the values.
+ * @param blob The arguments, program name first, each followed by a NUL.
+ * @param len Length of the blob in bytes.
+ * @return FERR_OK on success, or the code of the first error.
+ */
+flag_err_t hay_flags_parse_blob_r(flag_result_t *res, const char *blob,
+                                  size_t len) {
+  if (!res) {
+    return FERR_ARGS;
+  }
+  if (!blob && len) {
+    res->error = (flag_error_t){FERR_ARGS, EINVAL, -1, nullptr};
+    res->args = nullptr;
+    res->nargs = 0;
+    return FERR_ARGS;
+  }
+
+  flags_parser_t p;
+  if (!flags_result_begin(res, &p)) {
+    return flags_result_end(res, &p);
+  }
+  p.borrow = true;
+  const char *end = len ? blob + len : blob;
+  for (const char *tok = blob; tok < end; p.arg++) {
+    const char *nul = memchr(tok, '\0', (size_t)(end - tok));
+    size_t n = nul ? (size_t)(nul - tok) : (size_t)(end - tok);
+    if (p.arg > 0) { // Skip the program name.
+      const char *arg = nul ? tok : flags_ctx_strndup(res->ctx, tok, n);
+      if (arg) {
+        flags_parser_feed(&p, arg, n);
+      } else {
+        flags_parser_fail(&p, FERR_NOMEM, ENOMEM, nullptr);
+      }
+    }
+    tok = nul ? nul + 1 : end;
+  }
+  return flags_result_end(res, &p);
+}
+
+/**
+ * @brief Parses blobs one after the other into the same result.
+ *
+ * @param res The result every blob is parsed into.
+ * @param blobs The blobs.
+ * @param n The number of blobs.
+ * @param fn Called after each parse, with the result and the index of the
+ *           blob; a nonzero return stops the scan.
+ * @param ud Passed to fn.
+ * @return The number of failed parses among the blobs scanned, or -1 with
+ *         `errno` set to `EINVAL`.
+ */
+long hay_flags_scan_blobs(flag_result_t *res, const flag_view_t *blobs,
+                          size_t n, flag_scan_fn_t fn, void *ud) {
+  if (!res || (n && !blobs) || !fn) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  long failed = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (hay_flags_parse_blob_r(res, blobs[i].ptr, blobs[i].len) != FERR_OK) {
+      failed++;
+    }
+    if (fn(res, i, ud)) {
+      break;
+    }
+  }
+  return failed;
+}
+
+/**
+ * @brief Returns the copy of a flag held by a result.
+ *
+ * @param res The result to read.
+ * @param flag The flag to look up, by its long name.
+ * @return The copy, or nullptr if the schema has no such flag.
+ */
+flag_t *hay_flags_result_get(flag_result_t *res, const flag_t *flag) {
+  if (!res || !flag || !flag->name) {
+    return nullptr;
+  }
+  uint32_t idx =
+      flags_schema_find_long(res->schema, flag->name, strlen(flag->name));
+  return idx ? &res->flags[idx - 1] : nullptr;
+}
+
+/**
+ * @brief Returns the copy of the flag at an index of the schema.
+ *
+ * @param res The result to read.
+ * @param idx Index of the flag in the schema; it must be in range.
+ * @return The copy.
+ */
+flag_t *flags_result_at(flag_result_t *res, uint32_t idx) {
+  return &res->flags[idx];
+}
+
+/**
+ * @brief Iterates over the flags set by the last parse of a result.
+ *
+ * Scans the bitset of the result a word at a time, skipping 64 unset flags
+ * per step.
+ *
+ * @param res The result to read.
+ * @param pos Cursor, 0 to start; moved past the returned flag.
+ * @return The next set flag in schema order, or nullptr if there is none.
+ */
+flag_t *hay_flags_result_next(flag_result_t *res, size_t *pos) {
+  if (!res || !pos) {
+    return nullptr;
+  }
+  size_t count = res->schema->count;
+  for (size_t i = *pos; i < count;) {
+    uint64_t word = res->set[i / 64] >> (i % 64);
+    if (word) {
+      i += (size_t)__builtin_ctzll(word);
+      *pos = i + 1;
+      return &res->flags[i];
+    }
+    i = (i / 64 + 1) * 64;
+  }
+  *pos = count;
+  return nullptr;
+}
+
+/**
+ * @brief Returns the first error raised by the last parse of a result.
+ *
+ * @param res The result to read.
+ * @return The error details.
+ */
+const flag_error_t *hay_flags_result_error(const flag_result_t *res) {
+  return res ? &res->error : nullptr;
+}
+
+/**
+ * @brief Returns the operands met by the last parse of a result.
+ *
+ * @param res The result to read.
+ * @param count Receives the number of operands.
+ * @return The operands, or nullptr if there are none.
+ */
+char *const *hay_flags_result_args(const flag_result_t *res, size_t *count) {
+  if (!res) {
+    *count = 0;
+    return nullptr;
+  }
+  *count = res->nargs;
+  return res->args;
+}
+
+/**
+ * @struct flags_batch
+ * @brief Work shared by the threads of a batch parse.
+ */
+typedef struct flags_batch {
+  flag_result_t **results;   ///< Destination of each vector.
+  const flag_argv_t *inputs; ///< The vectors to parse.
+  size_t n;                  ///< Number of vectors.
+  atomic_size_t next;        ///< Next vector to hand out.
+  atomic_long failed;        ///< Number of failed parses so far.
+} flags_batch_t;
+
+/**
+ * @brief Parses vectors of a batch until none is left.
+ *
+ * @param arg The flags_batch_t shared by every thread.
+ * @return nullptr.
+ */
+static void *flags_batch_worker(void *arg) {
+  flags_batch_t *batch = arg;
+  long failed = 0;
+  for (;;) {
+    size_t i = atomic_fetch_add_explicit(&batch->next, 1, memory_order_relaxed);
+    if (i >= batch->n) {
+      break;
+    }
+    const flag_argv_t *in = &batch->inputs[i];
+    if (hay_flags_parse_r(batch->results[i], in->argc, in->argv) != FERR_OK) {
+      failed++;
+    }
+  }
+  atomic_fetch_add_explicit(&batch->failed, failed, memory_order_relaxed);
+  return nullptr;
+}
+
+/**
+ * @brief Resolves the number of threads asked for a batch.
+ *
+ * @param threads The number asked, or 0 for one per online CPU.
+ * @return The number of threads to use, the caller included, at least 1.
+ */
+static unsigned flags_batch_threads(unsigned threads) {
+  if (threads == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? (unsigned)cpus : 1;
+  }
+  return threads > FLAGS_BATCH_THREADS ? FLAGS_BATCH_THREADS : threads;
+}
+
+/**
+ * @brief Parses several argument vectors in parallel.
+ *
+ * The workers are started for this call and joined before it returns, which
+ * keeps a one-off batch free of any setup; callers running many batches use
+ * a flag_pool_t instead.
+ *
+ * @param results One distinct result per vector.
+ * @param inputs The argument vectors.
+ * @param n The number of vectors.
+ * @param threads The number of threads to use, or 0 for one per online CPU.
+ *                A minimal build always uses the calling thread alone.
+ * @return The number of failed parses, or -1 with `errno` set to `EINVAL`.
+ */
+long hay_flags_parse_batch(flag_result_t **results, const flag_argv_t *inputs,
+                           size_t n, unsigned threads) {
+  if (!results || !inputs) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  threads = flags_batch_threads(threads);
+  if (threads > n) {
+    threads = n ? (unsigned)n : 1;
+  }
+
+  flags_batch_t batch = {.results = results, .inputs = inputs, .n = n};
+  atomic_init(&batch.next, 0);
+  atomic_init(&batch.failed, 0);
+
+#if HAY_FLAGS_MINIMAL
+  // Without threads, the calling thread parses every vector.
+  flags_batch_worker(&batch);
+#else
+  // The calling thread is one of the workers.
+  pthread_t workers[FLAGS_BATCH_THREADS - 1];
+  unsigned started = 0;
+  while (started + 1 < threads &&
+         pthread_create(&workers[started], nullptr, flags_batch_worker,
+                        &batch) == 0) {
+    started++;
+  }
+  flags_batch_worker(&batch);
+  for (unsigned t = 0; t < started; t++) {
+    pthread_join(workers[t], nullptr);
+  }
+#endif
+  return atomic_load(&batch.failed);
+}
+
+/**
+ * @struct flag_pool
+ * @brief Worker threads kept between batch parses.
+ *
+ * A batch is posted under the lock with a new epoch; every worker runs each
+ * epoch once, and the last one out wakes the thread that posted it.
+ */
+struct flag_pool {
+#if !HAY_FLAGS_MINIMAL
+  pthread_mutex_t lock;  ///< Guards every field below.
+  pthread_cond_t work;   ///< Signalled when a batch is posted or on stop.
+  pthread_cond_t done;   ///< Signalled when a batch is finished.
+  flags_batch_t *batch;  ///< The batch being parsed, or nullptr.
+  unsigned long epoch;   ///< Number of batches posted so far.
+  unsigned busy;         ///< Workers still in the current batch.
+  bool stop;             ///< Set by hay_flags_pool_destroy().
+  unsigned nworkers;     ///< Number of running workers.
+  pthread_t workers[];   ///< The workers.
+#else
+  char unused; ///< A minimal build parses on the calling thread.
+#endif
+};
+
+#if !HAY_FLAGS_MINIMAL
+/**
+ * @brief Runs every batch posted to a pool until the pool is stopped.
+ *
+ * @param arg The flag_pool_t.
+ * @return nullptr.
+ */
+static void *flags_pool_worker(void *arg) {
+  flag_pool_t *pool = arg;
+  // A worker may start after the first batch is posted, so it counts from
+  // the epoch the pool was created with rather than the current one.
+  unsigned long seen = 0;
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    while (!pool->stop && pool->epoch == seen) {
+      pthread_cond_wait(&pool->work, &pool->lock);
+    }
+    if (pool->stop) {
+      break;
+    }
+    seen = pool->epoch;
+    flags_batch_t *batch = pool->batch;
+    pthread_mutex_unlock(&pool->lock);
+    flags_batch_worker(batch);
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->busy == 0) {
+      pthread_cond_broadcast(&pool->done);
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return nullptr;
+}
+
+/**
+ * @brief Stops and joins the workers of a pool.
+ *
+ * @param pool The pool.
+ */
+static void flags_pool_stop(flag_pool_t *pool) {
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = true;
+  pthread_cond_broadcast(&pool->work);
+  pthread_mutex_unlock(&pool->lock);
+  for (unsigned t = 0; t < pool->nworkers; t++) {
+    pthread_join(pool->workers[t], nullptr);
+  }
+}
+#endif
+
+/**
+ * @brief Starts the worker threads of a pool for repeated batch parses.
+ *
+ * @param threads The number of threads to use, the calling thread of each
+ *                batch included, or 0 for one per online CPU.
+ * @return The pool, or nullptr with `errno` set to `ENOMEM`.
+ */
+flag_pool_t *hay_flags_pool_create(unsigned threads) {
+#if HAY_FLAGS_MINIMAL
+  (void)threads;
+  flag_pool_t *pool = calloc(1, sizeof(flag_pool_t));
+  if (!pool) {
+    errno = ENOMEM;
+  }
+  return pool;
+#else
+  threads = flags_batch_threads(threads);
+  flag_pool_t *pool =
+      calloc(1, sizeof(flag_pool_t) + (threads - 1) * sizeof(pthread_t));
+  if (!pool) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  pthread_mutex_init(&pool->lock, nullptr);
+  pthread_cond_init(&pool->work, nullptr);
+  pthread_cond_init(&pool->done, nullptr);
+  // Workers that cannot be started leave the batches to fewer threads.
+  while (pool->nworkers + 1 < threads &&
+         pthread_create(&pool->workers[pool->nworkers], nullptr,
+                        flags_pool_worker, pool) == 0) {
+    pool->nworkers++;
+  }
+  return pool;
+#endif
+}
+
+/**
+ * @brief Stops the workers of a pool and releases it.
+ *
+ * @param pool The pool to release. May be nullptr. No batch may be running.
+ */
+void hay_flags_pool_destroy(flag_pool_t *pool) {
+  if (!pool) {
+    return;
+  }
+#if !HAY_FLAGS_MINIMAL
+  flags_pool_stop(pool);
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->work);
+  pthread_mutex_destroy(&pool->lock);
+#endif
+  free(pool);
+}
+
+/**
+ * @brief Parses several argument vectors on the workers of a pool.
+ *
+ * @param pool The pool.
+ * @param results One distinct result per vector.
+ * @param inputs The argument vectors.
+ * @param n The number of vectors.
+ * @return The number of failed parses, or -1 with `errno` set to `EINVAL`.
+ */
+long hay_flags_pool_parse(flag_pool_t *pool, flag_result_t **results,
+                          const flag_argv_t *inputs, size_t n) {
+  if (!pool || !results || !inputs) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  flags_batch_t batch = {.results = results, .inputs = inputs, .n = n};
+  atomic_init(&batch.next, 0);
+  atomic_init(&batch.failed, 0);
+
+#if HAY_FLAGS_MINIMAL
+  flags_batch_worker(&batch);
+#else
+  pthread_mutex_lock(&pool->lock);
+  while (pool->batch) { // One batch at a time.
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+  if (pool->nworkers) {
+    pool->batch = &batch;
+    pool->epoch++;
+    pool->busy = pool->nworkers;
+    pthread_cond_broadcast(&pool->work);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  // The calling thread is one of the workers.
+  flags_batch_worker(&batch);
+
+  pthread_mutex_lock(&pool->lock);
+  if (pool->batch == &batch) {
+    while (pool->busy) {
+      pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pool->batch = nullptr;
+    pthread_cond_broadcast(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->lock);
+#endif
+  return atomic_load(&batch.failed);
+}
@@ -0,0 +1,284 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Builds a frozen schema, on the heap or in a context arena.
+ *
+ * Copies the flag pointers and the long names (into one pool), hashes every
+ * long name into an open-addressing table sized to at least twice the flag
+ * count, and fills the 256-entry short-name table. The flags themselves are
+ * not copied; they must outlive the schema.
+ *
+ * @param flags Array of pointers to flag_t structures, terminated by nullptr.
+ * @param ctx Context to allocate the schema in, or nullptr for the heap.
+ * @return Pointer to the new schema, or nullptr if an error occurs. In case
+ *         of error, `errno` is set to indicate the error (`EINVAL` for a null
+ *         array, `EEXIST` for a duplicated long or short name, `ENOMEM` if
+ *         allocation fails).
+ */
+flag_schema_t *flags_schema_build(flag_t **flags, flag_ctx_t *ctx) {
+  if (!flags) {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  size_t count = 0;
+  size_t pool = 0;
+  while (flags[count] != nullptr) {
+    pool += strlen(flags[count]->name) + 1;
+    count++;
+  }
+  if (pool > UINT32_MAX) {
+    errno = ENOMEM; // Pool offsets are 32 bits wide.
+    return nullptr;
+  }
+
+  // Keep the load factor at or below 1/2 so probe chains stay short.
+  size_t cap = 8;
+  while (cap < count * 2) {
+    cap <<= 1;
+  }
+
+  // Schema, flag pointers, slots and names live in a single block.
+  size_t flags_off = sizeof(flag_schema_t);
+  size_t slots_off = flags_off + (count + 1) * sizeof(flag_t *);
+  slots_off = (slots_off + _Alignof(flag_slot_t) - 1) &
+              ~(size_t)(_Alignof(flag_slot_t) - 1);
+  size_t names_off = slots_off + cap * sizeof(flag_slot_t);
+  size_t size = names_off + pool;
+  char *block = ctx ? flags_ctx_alloc(ctx, size) : malloc(size);
+  if (!block) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+
+  memset(block, 0, size);
+  flag_schema_t *schema = (flag_schema_t *)block;
+  schema->ctx = ctx;
+  schema->flags = (flag_t **)(block + flags_off);
+  schema->slots = (flag_slot_t *)(block + slots_off);
+  schema->names = block + names_off;
+  schema->count = count;
+  schema->cap = cap;
+
+  char *name = block + names_off;
+  for (size_t i = 0; i < count; i++) {
+    flag_t *flag = flags[i];
+    schema->flags[i] = flag;
+    size_t len = strlen(flag->name) + 1;
+    memcpy(name, flag->name, len);
+    name += len;
+
+    if (flag->short_name) {
+      unsigned char c = (unsigned char)flag->short_name;
+      if (schema->shorts[c]) {
+        hay_flags_schema_destroy(schema);
+        errno = EEXIST; // Two flags share a short name.
+        return nullptr;
+      }
+      schema->shorts[c] = (uint32_t)(i + 1);
+    }
+  }
+  schema->flags[count] = nullptr;
+
+  if (flags_schema_index(schema) != 0) {
+    hay_flags_schema_destroy(schema);
+    errno = EEXIST;
+    return nullptr;
+  }
+
+  return schema;
+}
+
+/**
+ * @brief Hashes every long name of a schema into its slot table.
+ *
+ * Runs when a schema is built, and on first use for schemas declared with
+ * HAY_FLAGS_STATIC(), whose slot table is zeroed static storage. Either way
+ * the names are read from the pool of the schema, in the order of its flags.
+ *
+ * @param schema The schema to index. Its slots must all be empty.
+ * @return 0 on success, or -1 with `errno` set to `EEXIST` if two flags share
+ *         a long name.
+ */
+int flags_schema_index(flag_schema_t *schema) {
+  size_t mask = schema->cap - 1;
+  uint32_t off = 0;
+  for (size_t i = 0; i < schema->count; i++) {
+    const char *name = schema->names + off;
+    uint32_t len = (uint32_t)strlen(name);
+    uint32_t h = flags_hash(name, len);
+    for (size_t s = h & mask;; s = (s + 1) & mask) {
+      flag_slot_t *slot = &schema->slots[s];
+      if (!slot->idx) {
+        *slot = (flag_slot_t){h, (uint32_t)(i + 1), off, len};
+        break;
+      }
+      if (slot->hash == h && slot->len == len &&
+          memcmp(schema->names + slot->name, name, len) == 0) {
+        errno = EEXIST; // Two flags share a long name.
+        return -1;
+      }
+    }
+    off += len + 1;
+  }
+  __atomic_store_n(&schema->indexed, true, __ATOMIC_RELEASE);
+  return 0;
+}
+
+/**
+ * @brief Takes the lock guarding the caches of a schema.
+ *
+ * The caches (the index of a static schema, the sorted index and the help)
+ * are not part of what the schema means, so they are built through a const
+ * schema; this lock keeps two threads from building one at once. The
+ * members are public for HAY_FLAGS_STATIC(), which is why they are plain
+ * types accessed through the GCC atomic builtins rather than C11 atomics.
+ *
+ * @param schema The schema whose caches are about to be built.
+ * @return The schema, writable.
+ */
+flag_schema_t *flags_schema_lock(const flag_schema_t *schema) {
+  flag_schema_t *s = (flag_schema_t *)schema;
+  while (__atomic_test_and_set(&s->lock, __ATOMIC_ACQUIRE)) {
+    sched_yield(); // Building a cache takes one pass over the flags.
+  }
+  return s;
+}
+
+/**
+ * @brief Releases the lock taken by flags_schema_lock(), publishing what was
+ *        built under it.
+ *
+ * @param schema The schema.
+ */
+void flags_schema_unlock(flag_schema_t *schema) {
+  __atomic_clear(&schema->lock, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Builds the caches of a schema that are still missing.
+ *
+ * @param schema The schema about to be used.
+ * @param sorted Whether the sorted index is needed.
+ * @return 0 on success, or -1 with `errno` set.
+ */
+static int flags_schema_prepare(const flag_schema_t *schema, bool sorted) {
+  // Published caches are never rebuilt, so once both are seen no lock is
+  // needed.
+  if (__atomic_load_n(&schema->indexed, __ATOMIC_ACQUIRE) &&
+      (!sorted || __atomic_load_n(&schema->sorted, __ATOMIC_ACQUIRE))) {
+    return 0;
+  }
+  flag_schema_t *s = flags_schema_lock(schema);
+  int res = 0;
+  if (!s->indexed) {
+    res = flags_schema_index(s);
+  }
+  if (res == 0 && sorted && !s->sorted) {
+    res = flags_schema_sort(s);
+  }
+  flags_schema_unlock(s);
+  return res;
+}
+
+/**
+ * @brief Makes sure a schema is indexed before it is used.
+ *
+ * Only schemas declared with HAY_FLAGS_STATIC() can reach this point without
+ * a hash index; they are indexed in place on first use. The sorted index is
+ * built the first time a schema with FSO_ABBREV is used. Both are safe to
+ * race for.
+ *
+ * @param schema The schema about to be used.
+ * @return 0 on success, or -1 with `errno` set.
+ */
+int flags_schema_ready(const flag_schema_t *schema) {
+  return flags_schema_prepare(schema, schema->opts & FSO_ABBREV);
+}
+
+/**
+ * @brief Same as flags_schema_ready(), but always builds the sorted index.
+ *
+ * @param schema The schema about to be searched by prefix.
+ * @return 0 on success, or -1 with `errno` set.
+ */
+int flags_schema_ready_sorted(const flag_schema_t *schema) {
+  return flags_schema_prepare(schema, true);
+}
+
+/**
+ * @brief Builds a frozen schema from an array of flags.
+ *
+ * @param flags Array of pointers to flag_t structures, terminated by nullptr.
+ * @return Pointer to the new schema, or nullptr if an error occurs. In case
+ *         of error, `errno` is set to indicate the error.
+ */
+flag_schema_t *hay_flags_schema_create(flag_t **flags) {
+  return flags_schema_build(flags, nullptr);
+}
+
+/**
+ * @brief Releases a schema created by hay_flags_schema_create().
+ *
+ * Schemas that live in a context arena are released with their context.
+ *
+ * @param schema The schema to release. May be nullptr.
+ */
+void hay_flags_schema_destroy(flag_schema_t *schema) {
+  if (schema && !schema->ctx) {
+    free(schema->help);
+    free(schema->sorted);
+    free(schema);
+  }
+}
+
+/**
+ * @brief Sets the options of a schema.
+ *
+ * @param schema The schema to configure.
+ * @param opts Bitwise OR of flag_schema_opt_t values.
+ */
+void hay_flags_schema_set_opts(flag_schema_t *schema, unsigned opts) {
+  if (schema) {
+    schema->opts = opts;
+  }
+}
+
+/**
+ * @brief Looks up a flag by its long name.
+ *
+ * @param schema The schema to search.
+ * @param name Start of the name; it does not need to be null-terminated.
+ * @param len Length of the name in bytes.
+ * @return Index of the matching flag plus one, or 0 if there is none.
+ */
+uint32_t flags_schema_find_long(const flag_schema_t *schema, const char *name,
+                                size_t len) {
+  uint32_t h = flags_hash(name, len);
+  size_t mask = schema->cap - 1;
+  for (size_t s = h & mask;; s = (s + 1) & mask) {
+    const flag_slot_t *slot = &schema->slots[s];
+    if (!slot->idx) {
+      return 0;
+    }
+    if (slot->hash == h && slot->len == len &&
+        memcmp(schema->names + slot->name, name, len) == 0) {
+      return slot->idx;
+    }
+  }
+}
+
+/**
+ * @brief Looks up a flag by its short name.
+ *
+ * @param schema The schema to search.
+ * @param c The short name.
+ * @return Index of the matching flag plus one, or 0 if there is none.
+ */
+uint32_t flags_schema_find_short(const flag_schema_t *schema, char c) {
+  return schema->shorts[(unsigned char)c];
+}
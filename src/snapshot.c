@@ -0,0 +1,630 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#if !HAY_FLAGS_MINIMAL
+#include <stdio.h>
+#endif
+
+/// First bytes of every snapshot.
+#define FLAGS_SNAP_MAGIC "HAYS"
+/// Layout version, bumped on any change to the structures below or to the
+/// values of flag_src_t.
+#define FLAGS_SNAP_VERSION 2
+/// Reads back as another value on a machine of the other byte order.
+#define FLAGS_SNAP_ENDIAN 0x0102
+
+/**
+ * @struct flags_snap_head
+ * @brief Header at offset 0 of a snapshot.
+ */
+typedef struct flags_snap_head {
+  char magic[4];    ///< FLAGS_SNAP_MAGIC, without terminator.
+  uint16_t version; ///< FLAGS_SNAP_VERSION.
+  uint16_t endian;  ///< FLAGS_SNAP_ENDIAN, in the byte order of the writer.
+  uint32_t count;   ///< Number of entries following the header.
+  uint32_t size;    ///< Size of the whole snapshot in bytes.
+} flags_snap_head_t;
+
+/**
+ * @struct flags_snap_entry
+ * @brief One set flag of a snapshot. Every offset is from the start of the
+ *        snapshot.
+ */
+typedef struct flags_snap_entry {
+  uint32_t name; ///< Offset of the null-terminated long name.
+  uint8_t type;  ///< flag_ty_t of the flag.
+  uint8_t src;   ///< flag_src_t of the value.
+  uint16_t pad;  ///< Zero.
+  uint32_t len;  ///< Length of a string, or number of items of a list.
+  uint32_t pad2; ///< Zero.
+  uint64_t val;  ///< Scalar value, or offset of the string or the items.
+} flags_snap_entry_t;
+
+/**
+ * @struct flags_snap_str
+ * @brief One item of an FT_STR_LIST in a snapshot.
+ */
+typedef struct flags_snap_str {
+  uint32_t off; ///< Offset of the null-terminated item.
+  uint32_t len; ///< Length of the item in bytes.
+} flags_snap_str_t;
+
+/**
+ * @struct flags_snap_writer
+ * @brief Position in a snapshot being laid out, or written once sized.
+ */
+typedef struct flags_snap_writer {
+  unsigned char *base; ///< The zeroed snapshot, nullptr while sizing it.
+  size_t off;          ///< Bytes laid out so far.
+} flags_snap_writer_t;
+
+/**
+ * @brief Lays out bytes at the end of a snapshot.
+ *
+ * @param w The writer.
+ * @param src The bytes to copy, or nullptr to only reserve room.
+ * @param len Number of bytes.
+ * @param align Alignment of the first byte (a power of two).
+ * @return Offset of the first byte.
+ */
+static size_t flags_snap_put(flags_snap_writer_t *w, const void *src,
+                             size_t len, size_t align) {
+  w->off = (w->off + align - 1) & ~(align - 1);
+  size_t at = w->off;
+  if (w->base && src && len) {
+    memcpy(w->base + at, src, len);
+  }
+  w->off += len;
+  return at;
+}
+
+/**
+ * @brief Lays out a string and its terminator.
+ *
+ * @return Offset of the string.
+ */
+static uint32_t flags_snap_str(flags_snap_writer_t *w, const char *s,
+                               size_t len) {
+  size_t at = flags_snap_put(w, s, len, 1);
+  flags_snap_put(w, "", 1, 1);
+  return (uint32_t)at;
+}
+
+/**
+ * @brief Lays out every set flag of a schema.
+ *
+ * Runs twice: once without a buffer to size the snapshot, once to fill it.
+ *
+ * @param schema The schema to save.
+ * @param w The writer.
+ */
+static void flags_snap_write(const flag_schema_t *schema,
+                             flags_snap_writer_t *w) {
+  uint32_t count = 0;
+  for (size_t i = 0; i < schema->count; i++) {
+    count += schema->flags[i]->is_set;
+  }
+  size_t head = flags_snap_put(w, nullptr, sizeof(flags_snap_head_t), 8);
+  size_t entries =
+      flags_snap_put(w, nullptr, count * sizeof(flags_snap_entry_t), 8);
+
+  uint32_t n = 0;
+  for (size_t i = 0; i < schema->count; i++) {
+    const flag_t *flag = schema->flags[i];
+    if (!flag->is_set) {
+      continue;
+    }
+    flags_snap_entry_t e = {.type = (uint8_t)flag->type,
+                            .src = (uint8_t)flag->src};
+    e.name = flags_snap_str(w, flag->name, strlen(flag->name));
+
+    const flag_list_t *l = &flag->val.val_list;
+    switch (flag->type) {
+    case FT_STR:
+      e.len = (uint32_t)flag->val.val_view.len;
+      e.val = flags_snap_str(w, flag->val.val_view.ptr, e.len);
+      break;
+    case FT_STR_LIST: {
+      e.len = (uint32_t)l->len;
+      size_t items =
+          flags_snap_put(w, nullptr, l->len * sizeof(flags_snap_str_t),
+                         _Alignof(flags_snap_str_t));
+      for (size_t k = 0; k < l->len; k++) {
+        const flag_view_t *v = (const flag_view_t *)l->items + k;
+        flags_snap_str_t s = {flags_snap_str(w, v->ptr, v->len),
+                              (uint32_t)v->len};
+        if (w->base) {
+          memcpy(w->base + items + k * sizeof(s), &s, sizeof(s));
+        }
+      }
+      e.val = items;
+      break;
+    }
+    case FT_INT_LIST:
+      e.len = (uint32_t)l->len;
+      e.val = flags_snap_put(w, l->items, l->len * sizeof(int64_t), 8);
+      break;
+    case FT_INT:
+      e.val = (uint64_t)(int64_t)flag->val.val_int;
+      break;
+    case FT_BOOL:
+      e.val = flag->val.val_bool;
+      break;
+    case FT_COUNT:
+      e.val = flag->val.val_count;
+      break;
+    case FT_CHOICE:
+      e.val = flag->val.val_choice;
+      break;
+    HAY_FLAGS__DEPRECATED_PUSH
+    case FT_NULL:
+    HAY_FLAGS__DEPRECATED_POP
+      break;
+    default:
+      // The remaining types are all 64 bits wide.
+      memcpy(&e.val, &flag->val, sizeof(e.val));
+      break;
+    }
+    if (w->base) {
+      memcpy(w->base + entries + n++ * sizeof(e), &e, sizeof(e));
+    }
+  }
+
+  if (w->base) {
+    flags_snap_head_t h = {.version = FLAGS_SNAP_VERSION,
+                           .endian = FLAGS_SNAP_ENDIAN,
+                           .count = count,
+                           .size = (uint32_t)w->off};
+    memcpy(h.magic, FLAGS_SNAP_MAGIC, sizeof(h.magic));
+    memcpy(w->base + head, &h, sizeof(h));
+  }
+}
+
+/**
+ * @brief Saves the set flags of a schema into a position-independent blob.
+ *
+ * @param schema The schema to save.
+ * @param len Receives the size of the blob in bytes.
+ * @return The blob, to be released with free(), or nullptr if an error
+ *         occurs. In case of error, `errno` is set to indicate the error.
+ */
+void *hay_flags_snapshot(const flag_schema_t *schema, size_t *len) {
+  if (!schema || !len) {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  flags_snap_writer_t w = {nullptr, 0};
+  flags_snap_write(schema, &w);
+  if (w.off > UINT32_MAX) {
+    errno = EOVERFLOW; // Offsets are 32 bits wide.
+    return nullptr;
+  }
+  size_t size = w.off;
+  unsigned char *blob = malloc(size);
+  if (!blob) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  memset(blob, 0, size);
+  w = (flags_snap_writer_t){blob, 0};
+  flags_snap_write(schema, &w);
+  *len = size;
+  return blob;
+}
+
+/**
+ * @brief Checks that a range lies inside a snapshot.
+ */
+static bool flags_snap_within(size_t size, uint64_t off, uint64_t len) {
+  return off <= size && len <= size - off;
+}
+
+/**
+ * @brief Checks one entry of a snapshot against its bounds and the schema.
+ *
+ * @param base The snapshot.
+ * @param size Size of the snapshot in bytes.
+ * @param e The entry.
+ * @param schema The schema the snapshot is loaded into.
+ * @return Index of the matching flag plus one, 0 if the schema has no flag of
+ *         that name, or -1 if the entry is malformed or of another type.
+ */
+static int64_t flags_snap_check(const unsigned char *base, size_t size,
+                                const flags_snap_entry_t *e,
+                                const flag_schema_t *schema) {
+  if (e->name >= size) {
+    return -1;
+  }
+  const char *name = (const char *)base + e->name;
+  const char *nul = memchr(name, '\0', size - e->name);
+  if (!nul) {
+    return -1;
+  }
+  uint32_t idx = flags_schema_find_long(schema, name, (size_t)(nul - name));
+  if (!idx) {
+    return 0;
+  }
+  if (schema->flags[idx - 1]->type != e->type || e->src > FS_ARGV) {
+    return -1;
+  }
+
+  bool ok = true;
+  switch (e->type) {
+  case FT_STR:
+    ok = flags_snap_within(size, e->val, (uint64_t)e->len + 1) &&
+         base[e->val + e->len] == '\0';
+    break;
+  case FT_STR_LIST:
+    ok = e->val % _Alignof(flags_snap_str_t) == 0 &&
+         flags_snap_within(size, e->val,
+                           (uint64_t)e->len * sizeof(flags_snap_str_t));
+    for (uint32_t k = 0; ok && k < e->len; k++) {
+      flags_snap_str_t s;
+      memcpy(&s, base + e->val + k * sizeof(s), sizeof(s));
+      ok = flags_snap_within(size, s.off, (uint64_t)s.len + 1) &&
+           base[s.off + s.len] == '\0';
+    }
+    break;
+  case FT_INT_LIST:
+    ok = e->val % _Alignof(int64_t) == 0 &&
+         flags_snap_within(size, e->val, (uint64_t)e->len * sizeof(int64_t));
+    break;
+  case FT_CHOICE: {
+    // IDs are only meaningful against the same set of choices.
+    const flag_choices_t *c = schema->flags[idx - 1]->choices;
+    ok = c && e->val < c->count;
+    break;
+  }
+  default:
+    break;
+  }
+  return ok ? (int64_t)idx : -1;
+}
+
+/**
+ * @brief Applies one checked entry of a snapshot to its flag.
+ *
+ * @param base The snapshot.
+ * @param e The entry.
+ * @param flag The flag of the same name and type.
+ * @return 0 on success, or -1 with `errno` set to `ENOMEM`.
+ */
+static int flags_snap_apply(const unsigned char *base,
+                            const flags_snap_entry_t *e, flag_t *flag) {
+  flag_list_t *l = &flag->val.val_list;
+  switch (e->type) {
+  case FT_STR:
+    if (flag->opts & FO_OWNED) {
+      free((char *)flag->val.val_str);
+    }
+    flag->opts &= ~FO_OWNED;
+    flag->val.val_view = (flag_view_t){(const char *)base + e->val, e->len};
+    break;
+  case FT_STR_LIST: {
+    // Views hold pointers, so they are rebuilt on load.
+    flag_ctx_t *arena = flags_list_arena(nullptr, flag);
+    flag_view_t *items =
+        arena ? flags_ctx_alloc(arena, (e->len ? e->len : 1) *
+                                           sizeof(flag_view_t))
+              : nullptr;
+    if (!items) {
+      errno = ENOMEM;
+      return -1;
+    }
+    for (uint32_t k = 0; k < e->len; k++) {
+      flags_snap_str_t s;
+      memcpy(&s, base + e->val + k * sizeof(s), sizeof(s));
+      items[k] = (flag_view_t){(const char *)base + s.off, s.len};
+    }
+    l->items = items;
+    l->len = l->cap = e->len;
+    break;
+  }
+  case FT_INT_LIST: {
+    // Copied, as the snapshot may be mapped read-only.
+    flag_ctx_t *arena = flags_list_arena(nullptr, flag);
+    int64_t *items =
+        arena ? flags_ctx_alloc(arena, (e->len ? e->len : 1) *
+                                           sizeof(int64_t))
+              : nullptr;
+    if (!items) {
+      errno = ENOMEM;
+      return -1;
+    }
+    memcpy(items, base + e->val, e->len * sizeof(int64_t));
+    l->items = items;
+    l->len = l->cap = e->len;
+    break;
+  }
+  case FT_INT:
+    flag->val.val_int = (int)(int64_t)e->val;
+    break;
+  case FT_BOOL:
+    flag->val.val_bool = e->val != 0;
+    break;
+  case FT_COUNT:
+    flag->val.val_count = (unsigned)e->val;
+    break;
+  case FT_CHOICE:
+    flag->val.val_choice = (unsigned)e->val;
+    break;
+  HAY_FLAGS__DEPRECATED_PUSH
+  case FT_NULL:
+  HAY_FLAGS__DEPRECATED_POP
+    break;
+  default:
+    memcpy(&flag->val, &e->val, sizeof(e->val));
+    break;
+  }
+  flag->is_set = true;
+  flag->src = (flag_src_t)e->src;
+  return 0;
+}
+
+/**
+ * @brief Loads a snapshot into the flags of a schema, without parsing.
+ *
+ * @param schema The schema receiving the values.
+ * @param blob The snapshot, aligned on 8 bytes. It must outlive the values.
+ * @param len Size of the snapshot in bytes.
+ * @return 0 on success, or -1 if an error occurs. In case of error, `errno` is
+ *         set to indicate the error.
+ */
+int hay_flags_schema_load_snapshot(const flag_schema_t *schema,
+                                   const void *blob, size_t len) {
+  if (!schema || !blob || (uintptr_t)blob % 8) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (flags_schema_ready(schema) != 0) {
+    return -1;
+  }
+
+  const unsigned char *base = blob;
+  flags_snap_head_t h;
+  if (len < sizeof(h)) {
+    errno = EINVAL;
+    return -1;
+  }
+  memcpy(&h, base, sizeof(h));
+  if (memcmp(h.magic, FLAGS_SNAP_MAGIC, sizeof(h.magic)) != 0 ||
+      h.version != FLAGS_SNAP_VERSION || h.endian != FLAGS_SNAP_ENDIAN ||
+      h.size != len ||
+      !flags_snap_within(len, sizeof(h),
+                         (uint64_t)h.count * sizeof(flags_snap_entry_t))) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  // Check every entry before touching any flag.
+  const unsigned char *entries = base + sizeof(h);
+  for (uint32_t i = 0; i < h.count; i++) {
+    flags_snap_entry_t e;
+    memcpy(&e, entries + i * sizeof(e), sizeof(e));
+    if (flags_snap_check(base, len, &e, schema) < 0) {
+      errno = EINVAL;
+      return -1;
+    }
+  }
+
+  for (uint32_t i = 0; i < h.count; i++) {
+    flags_snap_entry_t e;
+    memcpy(&e, entries + i * sizeof(e), sizeof(e));
+    int64_t idx = flags_snap_check(base, len, &e, schema);
+    flag_t *flag = idx ? schema->flags[idx - 1] : nullptr;
+    if (flag && e.src >= flag->src && flags_snap_apply(base, &e, flag) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Formats an unsigned number in decimal.
+ *
+ * @param buf Receives the digits; 20 bytes are enough.
+ * @param v The number.
+ * @return Number of digits written.
+ */
+static size_t flags_fmt_uint(char *buf, uint64_t v) {
+  char tmp[20];
+  size_t n = 0;
+  do {
+    tmp[n++] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v);
+  for (size_t i = 0; i < n; i++) {
+    buf[i] = tmp[n - 1 - i];
+  }
+  return n;
+}
+
+/**
+ * @brief Formats a signed number in decimal.
+ *
+ * @param buf Receives the text; 21 bytes are enough.
+ * @param v The number.
+ * @return Number of bytes written.
+ */
+static size_t flags_fmt_int(char *buf, int64_t v) {
+  if (v >= 0) {
+    return flags_fmt_uint(buf, (uint64_t)v);
+  }
+  buf[0] = '-';
+  return 1 + flags_fmt_uint(buf + 1, -(uint64_t)v);
+}
+
+/**
+ * @brief Formats the value of a scalar flag as it is written after `=`.
+ *
+ * @param flag The flag.
+ * @param buf Receives the text; 32 bytes are enough.
+ * @return Number of bytes written, or -1 with `errno` set to `ENOTSUP` if the
+ *         value cannot be formatted by this build.
+ */
+static long flags_fmt_value(const flag_t *flag, char *buf) {
+  switch (flag->type) {
+  case FT_INT:
+    return (long)flags_fmt_int(buf, flag->val.val_int);
+  case FT_INT64:
+    return (long)flags_fmt_int(buf, flag->val.val_int64);
+  case FT_UINT64:
+  case FT_SIZE:
+    return (long)flags_fmt_uint(buf, flag->val.val_uint64);
+  case FT_COUNT:
+    return (long)flags_fmt_uint(buf, flag->val.val_count);
+  case FT_DURATION: {
+    size_t n = flags_fmt_int(buf, flag->val.val_duration);
+    memcpy(buf + n, "ns", 2);
+    return (long)n + 2;
+  }
+  case FT_DOUBLE:
+#if HAY_FLAGS_MINIMAL
+    errno = ENOTSUP; // No exact formatting without stdio.
+    return -1;
+#else
+    return snprintf(buf, 32, "%.17g", flag->val.val_double);
+#endif
+  default:
+    return 0;
+  }
+}
+
+/**
+ * @brief Adds one `--name[=value]` token to a rendered argv.
+ *
+ * @param ctx The arena of the tokens.
+ * @param argv The argv being filled, or nullptr while counting.
+ * @param argc Number of tokens so far, incremented.
+ * @param name The long name.
+ * @param value The value, or nullptr for a bare flag.
+ * @param len Length of the value in bytes.
+ * @return 0 on success, or -1 with `errno` set to `ENOMEM`.
+ */
+static int flags_argv_put(flag_ctx_t *ctx, char **argv, int *argc,
+                          const char *name, const char *value, size_t len) {
+  if (argv) {
+    size_t name_len = strlen(name);
+    size_t size = 2 + name_len + (value ? 1 + len : 0) + 1;
+    char *tok = flags_ctx_alloc(ctx, size);
+    if (!tok) {
+      errno = ENOMEM;
+      return -1;
+    }
+    char *w = tok;
+    memcpy(w, "--", 2);
+    memcpy(w + 2, name, name_len);
+    w += 2 + name_len;
+    if (value) {
+      *w++ = '=';
+      memcpy(w, value, len);
+      w += len;
+    }
+    *w = '\0';
+    argv[*argc] = tok;
+  }
+  (*argc)++;
+  return 0;
+}
+
+/**
+ * @brief Adds the tokens that set one flag to a rendered argv.
+ *
+ * @return 0 on success, or -1 with `errno` set.
+ */
+static int flags_argv_flag(flag_ctx_t *ctx, char **argv, int *argc,
+                           const flag_t *flag) {
+  const flag_list_t *l = &flag->val.val_list;
+  char num[32];
+  switch (flag->type) {
+  HAY_FLAGS__DEPRECATED_PUSH
+  case FT_NULL:
+  HAY_FLAGS__DEPRECATED_POP
+    return flags_argv_put(ctx, argv, argc, flag->name, nullptr, 0);
+  case FT_BOOL:
+    return flag->val.val_bool
+               ? flags_argv_put(ctx, argv, argc, flag->name, nullptr, 0)
+               : flags_argv_put(ctx, argv, argc, flag->name, "false", 5);
+  case FT_STR:
+    return flags_argv_put(ctx, argv, argc, flag->name, flag->val.val_view.ptr,
+                          flag->val.val_view.len);
+  case FT_CHOICE: {
+    const char *name =
+        hay_flags_choices_name(flag->choices, flag->val.val_choice);
+    if (!name) {
+      errno = EINVAL;
+      return -1;
+    }
+    return flags_argv_put(ctx, argv, argc, flag->name, name, strlen(name));
+  }
+  case FT_STR_LIST:
+    for (size_t k = 0; k < l->len; k++) {
+      const flag_view_t *v = (const flag_view_t *)l->items + k;
+      if (flags_argv_put(ctx, argv, argc, flag->name, v->ptr, v->len) != 0) {
+        return -1;
+      }
+    }
+    return 0;
+  case FT_INT_LIST:
+    for (size_t k = 0; k < l->len; k++) {
+      size_t n = flags_fmt_int(num, ((const int64_t *)l->items)[k]);
+      if (flags_argv_put(ctx, argv, argc, flag->name, num, n) != 0) {
+        return -1;
+      }
+    }
+    return 0;
+  default: {
+    long n = flags_fmt_value(flag, num);
+    if (n < 0) {
+      return -1;
+    }
+    return flags_argv_put(ctx, argv, argc, flag->name, num, (size_t)n);
+  }
+  }
+}
+
+/**
+ * @brief Renders the set flags of a schema back to a minimal argv.
+ *
+ * @param ctx The context the argv and its tokens are allocated in.
+ * @param schema The schema to render.
+ * @param argv0 The program name stored in argv[0].
+ * @param argc Receives the number of tokens, argv[0] included.
+ * @return The argv, terminated by nullptr, or nullptr if an error occurs. In
+ *         case of error, `errno` is set to indicate the error.
+ */
+char **hay_flags_ctx_to_argv(flag_ctx_t *ctx, const flag_schema_t *schema,
+                             const char *argv0, int *argc) {
+  if (!ctx || !schema || !argv0 || !argc) {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  // Count the tokens, then fill them.
+  int n = 1;
+  for (size_t i = 0; i < schema->count; i++) {
+    const flag_t *flag = schema->flags[i];
+    if (flag->is_set && flags_argv_flag(ctx, nullptr, &n, flag) != 0) {
+      return nullptr;
+    }
+  }
+  char **argv = flags_ctx_alloc(ctx, ((size_t)n + 1) * sizeof(char *));
+  if (!argv) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+
+  argv[0] = (char *)argv0;
+  *argc = 1;
+  for (size_t i = 0; i < schema->count; i++) {
+    const flag_t *flag = schema->flags[i];
+    if (flag->is_set && flags_argv_flag(ctx, argv, argc, flag) != 0) {
+      return nullptr;
+    }
+  }
+  argv[*argc] = nullptr;
+  return argv;
+}
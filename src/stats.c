@@ -0,0 +1,92 @@
+#include "flags_internal.h"
+#include <errno.h>
+#include <stdatomic.h>
+
+#if HAY_FLAGS_STATS
+// The hook and its user data are read by parses on any thread. A writer makes
+// the sequence odd while it replaces them, so a reader retries instead of
+// pairing one hook with the user data of another.
+static atomic_uint flags_stats_seq;                 ///< Even when stable.
+static _Atomic(flag_stats_hook_t) flags_stats_hook; ///< Installed hook.
+static _Atomic(void *) flags_stats_ud;              ///< Its user data.
+
+/**
+ * @brief Reads the installed hook and its user data as one pair.
+ *
+ * @param ud Receives the user data.
+ * @return The hook, or nullptr if none is installed.
+ */
+static flag_stats_hook_t flags_stats_load(void **ud) {
+  for (;;) {
+    unsigned seq = atomic_load_explicit(&flags_stats_seq, memory_order_acquire);
+    flag_stats_hook_t hook =
+        atomic_load_explicit(&flags_stats_hook, memory_order_relaxed);
+    *ud = atomic_load_explicit(&flags_stats_ud, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if (!(seq & 1) &&
+        atomic_load_explicit(&flags_stats_seq, memory_order_relaxed) == seq) {
+      return hook;
+    }
+  }
+}
+
+/**
+ * @brief Starts collecting statistics for a parse.
+ *
+ * Clocks are only read when a hook is installed, so an untimed parse pays
+ * for a few counter increments and nothing else.
+ *
+ * @param p The parser state, with its context already set.
+ */
+void flags_stats_begin(flags_parser_t *p) {
+  p->stats = (flag_stats_t){0};
+  p->timed =
+      atomic_load_explicit(&flags_stats_hook, memory_order_relaxed) != nullptr;
+  p->start = FLAGS_CLOCK(p);
+  p->ctx_allocs = p->ctx ? p->ctx->stats.allocs : 0;
+}
+
+/**
+ * @brief Reports the statistics of a finished parse to the hook.
+ *
+ * @param p The parser state.
+ */
+void flags_stats_end(flags_parser_t *p) {
+  void *ud;
+  flag_stats_hook_t hook = flags_stats_load(&ud);
+  if (!hook) {
+    return;
+  }
+  if (p->ctx) {
+    p->stats.allocs += p->ctx->stats.allocs - p->ctx_allocs;
+  }
+  FLAGS_STAT_SINCE(p, ns_total, p->start);
+  hook(p->schema, &p->stats, ud);
+}
+#endif
+
+/**
+ * @brief Installs a process-wide hook called at the end of every parse.
+ *
+ * @param hook The hook, or nullptr to remove it.
+ * @param ud Passed to the hook.
+ * @return 0 on success, or -1 with `errno` set to `ENOTSUP` if statistics
+ *         are compiled out.
+ */
+int hay_flags_set_stats_hook(flag_stats_hook_t hook, void *ud) {
+#if HAY_FLAGS_STATS
+  unsigned seq = atomic_load_explicit(&flags_stats_seq, memory_order_relaxed);
+  do {
+    seq &= ~1u; // Wait for a concurrent writer to finish.
+  } while (!atomic_compare_exchange_weak(&flags_stats_seq, &seq, seq + 1));
+  atomic_store_explicit(&flags_stats_hook, hook, memory_order_relaxed);
+  atomic_store_explicit(&flags_stats_ud, ud, memory_order_relaxed);
+  atomic_store_explicit(&flags_stats_seq, seq + 2, memory_order_release);
+  return 0;
+#else
+  (void)hook;
+  (void)ud;
+  errno = ENOTSUP;
+  return -1;
+#endif
+}
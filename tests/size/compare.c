@@ -0,0 +1,63 @@
+/**
+ * @file compare.c
+ * @brief Compares the size and exec latency of the entry point linked against
+ *        the default and the minimal library.
+ *
+ * Prints one JSON object per variant:
+ *
+ *   {"variant":"minimal","bytes":...,"exec_us":...}
+ *
+ * and fails if either binary does not parse its arguments or, when they are
+ * linked statically (and so carry the libc code they pull in), if the minimal
+ * one is larger than the default one.
+ *
+ * Usage: size_compare <default binary> <minimal binary> [static]
+ */
+
+#include <assert.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+
+/// Number of runs averaged into exec_us.
+#define RUNS 200
+
+extern char **environ;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Runs the binary RUNS times; returns the mean latency of one run in us.
+static double exec_us(char *path) {
+  char *argv[] = {path,  "-p", "8080", "--ratio=1.0", "-t",
+                  "5s", "-vv", "-r",   "/",           NULL};
+  uint64_t t0 = now_ns();
+  for (int i = 0; i < RUNS; i++) {
+    pid_t pid;
+    int status;
+    assert(posix_spawn(&pid, path, NULL, NULL, argv, environ) == 0);
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+  return (double)(now_ns() - t0) / RUNS / 1000.0;
+}
+
+int main(int argc, char **argv) {
+  assert(argc == 3 || argc == 4);
+  static const char *names[] = {"default", "minimal"};
+  off_t bytes[2];
+  for (int i = 0; i < 2; i++) {
+    struct stat st;
+    assert(stat(argv[i + 1], &st) == 0);
+    bytes[i] = st.st_size;
+    printf("{\"variant\":\"%s\",\"bytes\":%lld,\"exec_us\":%.1f}\n", names[i],
+           (long long)bytes[i], exec_us(argv[i + 1]));
+  }
+  assert(argc == 3 || bytes[1] <= bytes[0]);
+}
@@ -0,0 +1,29 @@
+/**
+ * @file entry.c
+ * @brief A container entry point, linked against each variant of the library
+ *        by the size_compare test.
+ *
+ * Parses a static schema and writes nothing, so the binary holds only what
+ * the library itself pulls in.
+ */
+
+#include <hay/flags.h>
+
+#define ENTRY_FLAGS(X, T)                                                      \
+  X(T, port, 'p', FT_INT)                                                      \
+  X(T, root, 'r', FT_STR)                                                      \
+  X(T, ratio, 0, FT_DOUBLE)                                                    \
+  X(T, timeout, 't', FT_DURATION)                                              \
+  X(T, verbose, 'v', FT_COUNT)
+
+HAY_FLAGS_STATIC(entry_flags, ENTRY_FLAGS);
+
+int main(int argc, char **argv) {
+  hay_flags_schema_set_opts(&entry_flags, FSO_BORROW);
+  if (hay_flags_schema_parse(&entry_flags, argc, argv) != 0) {
+    return 2;
+  }
+  int port = hay_flags_getint(HAY_FLAGS_GET(entry_flags, port), 8080);
+  double ratio = hay_flags_getdouble(HAY_FLAGS_GET(entry_flags, ratio), 1.0);
+  return port == 8080 && ratio == 1.0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+#include <assert.h>
+#include <errno.h>
+#include <hay/flags.h>
+#include <string.h>
+
+int main() {
+  flag_t *verbose = hay_flags_create("verbose", 'v', FT_BOOL);
+  flag_t *version = hay_flags_create("version", 0, FT_BOOL);
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *portal = hay_flags_create("portal", 0, FT_STR);
+  flag_t *flags[] = {verbose, version, port, portal, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+
+  // Abbreviations are off by default.
+  char *argv[] = {"./test", "--verb"};
+  int rc = hay_flags_schema_parse(schema, 2, argv);
+  assert(rc == 0);
+  assert(!verbose->is_set);
+
+  // An exact name wins over the longer names it is a prefix of.
+  hay_flags_schema_set_opts(schema, FSO_ABBREV);
+  char *argv2[] = {"./test", "--verb", "--port", "1", "--porta=x"};
+  rc = hay_flags_schema_parse(schema, 5, argv2);
+  assert(rc == 0);
+  assert(verbose->is_set && !version->is_set);
+  assert(hay_flags_getint(port, 0) == 1);
+  assert(strcmp(hay_flags_getstr(portal, ""), "x") == 0);
+
+  // Ambiguous abbreviations are errors.
+  flag_result_t *res = hay_flags_result_create(schema);
+  char *argv3[] = {"./test", "--ver"};
+  flag_err_t code = hay_flags_parse_r(res, 2, argv3);
+  assert(code == FERR_AMBIGUOUS);
+  assert(hay_flags_result_error(res)->arg == 1);
+  char *argv4[] = {"./test", "--vers"};
+  code = hay_flags_parse_r(res, 2, argv4);
+  assert(code == FERR_OK);
+  assert(hay_flags_result_get(res, version)->is_set);
+  hay_flags_result_destroy(res);
+
+  // Completion returns the candidates in the order of their names.
+  const flag_t *out[4];
+  long got = hay_flags_complete(schema, "--po", out, 4);
+  assert(got == 2);
+  assert(out[0] == port && out[1] == portal);
+  got = hay_flags_complete(schema, "ver", out, 1);
+  assert(got == 2);
+  assert(out[0] == verbose);
+  got = hay_flags_complete(schema, "--", out, 4);
+  assert(got == 4);
+  assert(out[0] == port && out[3] == version);
+  got = hay_flags_complete(schema, "--x", out, 4);
+  assert(got == 0);
+  got = hay_flags_complete(schema, "--z", nullptr, 0);
+  assert(got == 0);
+  got = hay_flags_complete(nullptr, "--", out, 4);
+  assert(got == -1 && errno == EINVAL);
+
+  // An empty name abbreviates nothing, even with a single long name.
+  flag_t *lone = hay_flags_create("port", 0, FT_INT);
+  flag_t *lone_flags[] = {lone, nullptr};
+  char *argv5[] = {"./test", "--=42"};
+  rc = hay_flags_parse_opts(lone_flags, FSO_ABBREV, 2, argv5);
+  assert(rc == 0);
+  assert(!lone->is_set);
+
+  // The flag array API opts in through hay_flags_parse_opts().
+  char *argv6[] = {"./test", "--po=7"};
+  rc = hay_flags_parse(lone_flags, 2, argv6);
+  assert(rc == 0 && !lone->is_set);
+  rc = hay_flags_parse_opts(lone_flags, FSO_ABBREV, 2, argv6);
+  assert(rc == 0);
+  assert(hay_flags_getint(lone, 0) == 7);
+  hay_flags_destroy(lone);
+
+  // Options set after a result is created take effect on its next parse.
+  flag_schema_t *late = hay_flags_schema_create(flags);
+  flag_result_t *late_res = hay_flags_result_create(late);
+  hay_flags_schema_set_opts(late, FSO_ABBREV);
+  code = hay_flags_parse_r(late_res, 2, argv2);
+  assert(code == FERR_OK);
+  assert(hay_flags_result_get(late_res, verbose)->is_set);
+  code = hay_flags_parse_blob_r(late_res, "a\0--porta=y\0", 12);
+  assert(code == FERR_OK);
+  flag_t *late_portal = hay_flags_result_get(late_res, portal);
+  assert(strcmp(hay_flags_getstr(late_portal, ""), "y") == 0);
+  hay_flags_result_destroy(late_res);
+  hay_flags_schema_destroy(late);
+
+  hay_flags_schema_destroy(schema);
+  for (int i = 0; flags[i]; i++) {
+    hay_flags_destroy(flags[i]);
+  }
+}
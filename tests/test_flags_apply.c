@@ -0,0 +1,102 @@
+#include <assert.h>
+#include <errno.h>
+#include <hay/flags.h>
+#include <string.h>
+
+int main() {
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *host = hay_flags_create("host", 'H', FT_STR);
+  flag_t *verbose = hay_flags_create("verbose", 'v', FT_COUNT);
+  flag_t *tags = hay_flags_create("tag", 't', FT_STR_LIST);
+  flag_t *ratio = hay_flags_create("ratio", 'r', FT_DOUBLE);
+  flag_t *flags[] = {port, host, verbose, tags, ratio, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+
+  char *argv[] = {"./test", "--port", "8080", "--host", "a.example",
+                  "-vv",    "--tag",  "x",    "--tag",  "y"};
+  int rc = hay_flags_schema_parse(schema, 10, argv);
+  assert(rc == 0);
+  assert(hay_flags_schema_gen(schema) == 0);
+  assert(port->gen == 0);
+
+  // Only the flags named by the delta change, and they get the new
+  // generation.
+  uint64_t seen = hay_flags_schema_gen(schema);
+  char *d1[] = {"--port", "9090", "--host", "b.example"};
+  long got = hay_flags_schema_apply(schema, 4, d1);
+  assert(got == 2);
+  assert(hay_flags_schema_gen(schema) == 1);
+  assert(hay_flags_getint(port, 0) == 9090);
+  assert(strcmp(hay_flags_getstr(host, ""), "b.example") == 0);
+  assert(port->gen > seen && host->gen > seen);
+  assert(verbose->gen == 0 && tags->gen == 0 && ratio->gen == 0);
+  assert(verbose->val.val_count == 2);
+  assert(tags->val.val_list.len == 2);
+
+  // Setting a value to what it already was is not a change.
+  seen = hay_flags_schema_gen(schema);
+  char *d2[] = {"--port", "9090", "--host=b.example"};
+  got = hay_flags_schema_apply(schema, 3, d2);
+  assert(got == 0);
+  assert(hay_flags_schema_gen(schema) == seen);
+  assert(port->gen == seen);
+
+  // Lists and counts named by a delta are replaced, not extended.
+  char *d3[] = {"--tag", "z", "-v", "--ratio", "0.5"};
+  got = hay_flags_schema_apply(schema, 5, d3);
+  assert(got == 3);
+  assert(hay_flags_schema_gen(schema) == seen + 1);
+  assert(tags->val.val_list.len == 1);
+  assert(strcmp(((flag_view_t *)tags->val.val_list.items)[0].ptr, "z") == 0);
+  assert(verbose->val.val_count == 1);
+  assert(ratio->gen == seen + 1 && port->gen == seen);
+
+  // Lists and counts given the value they had are not changes either.
+  seen = hay_flags_schema_gen(schema);
+  char *d4[] = {"-v", "--tag", "z"};
+  long changed = hay_flags_schema_apply(schema, 3, d4);
+  assert(changed == 0);
+  assert(hay_flags_schema_gen(schema) == seen);
+  assert(verbose->gen == seen && tags->gen == seen);
+  char *d5[] = {"--tag", "z", "--tag", "w", "-vv"};
+  changed = hay_flags_schema_apply(schema, 5, d5);
+  assert(changed == 2);
+  assert(verbose->gen == seen + 1 && tags->gen == seen + 1);
+
+  // Repeated deltas reuse the arena of a list instead of growing it.
+  flag_ctx_stats_t before, after;
+  hay_flags_ctx_stats(tags->val.val_list.own, &before);
+  for (int i = 0; i < 1000; i++) {
+    char *d[] = {"--tag", i % 2 ? "odd" : "even", "--tag", "again"};
+    got = hay_flags_schema_apply(schema, 4, d);
+    assert(got == 1);
+  }
+  assert(tags->val.val_list.len == 2);
+  hay_flags_ctx_stats(tags->val.val_list.own, &after);
+  assert(after.allocs == before.allocs);
+  assert(after.reserved == before.reserved);
+
+  // Flags before a bad value keep their new value, and count as changed.
+  seen = hay_flags_schema_gen(schema);
+  char *bad[] = {"--host", "c.example", "--port", "nope"};
+  got = hay_flags_schema_apply(schema, 4, bad);
+  assert(got == -1);
+  assert(errno == EINVAL);
+  assert(strcmp(hay_flags_getstr(host, ""), "c.example") == 0);
+  assert(host->gen == seen + 1);
+  assert(hay_flags_getint(port, 0) == 9090);
+
+  char *missing[] = {"--port"};
+  got = hay_flags_schema_apply(schema, 1, missing);
+  assert(got == -1);
+  got = hay_flags_schema_apply(schema, 0, nullptr);
+  assert(got == 0);
+  got = hay_flags_schema_apply(nullptr, 0, nullptr);
+  assert(got == -1);
+
+  hay_flags_schema_destroy(schema);
+  for (size_t i = 0; flags[i]; i++) {
+    hay_flags_destroy(flags[i]);
+  }
+}
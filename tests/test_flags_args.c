@@ -0,0 +1,65 @@
+#include <assert.h>
+#include <hay/flags.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int main() {
+  char *argv[] = {"./test", "a.c", "-p", "80", "b.c", "-V",
+                  "--",     "-V",  "c.c", nullptr};
+  char *orig[9];
+  memcpy(orig, argv, sizeof(orig));
+  int argc = 9;
+
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *verbose = hay_flags_create("verbose", 'V', FT_COUNT);
+  flag_t *flags[] = {port, verbose, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+
+  // Operands are compacted into argv, in order; "--" ends the options.
+  int rc = hay_flags_schema_parse_args(schema, &argc, argv);
+  assert(rc == 0);
+  assert(argc == 5);
+  assert(argv[1] == orig[1] && argv[2] == orig[4]);
+  assert(argv[3] == orig[7] && argv[4] == orig[8]);
+  assert(argv[5] == nullptr);
+  assert(hay_flags_getint(port, 0) == 80);
+  assert(hay_flags_getcount(verbose, 0) == 1);
+
+  // Results collect operands too, including those of response files.
+  char path[] = "/tmp/hay_flags_args_XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  ssize_t wrote = write(fd, "in.txt -p 1 -- --port", 21);
+  assert(wrote == 21);
+  close(fd);
+  char at[64];
+  snprintf(at, sizeof(at), "@%s", path);
+
+  hay_flags_schema_set_opts(schema, FSO_RESPONSE_FILES);
+  flag_result_t *res = hay_flags_result_create(schema);
+  char *argv2[] = {"./test", "x", at, "y"};
+  flag_err_t code = hay_flags_parse_r(res, 4, argv2);
+  assert(code == FERR_OK);
+  size_t n;
+  char *const *args = hay_flags_result_args(res, &n);
+  assert(n == 4);
+  assert(args[0] == argv2[1]);
+  assert(strcmp(args[1], "in.txt") == 0);
+  assert(strcmp(args[2], "--port") == 0);
+  assert(args[3] == argv2[3]);
+  assert(hay_flags_getint(hay_flags_result_get(res, port), 0) == 1);
+
+  char *argv3[] = {"./test", "-V"};
+  code = hay_flags_parse_r(res, 2, argv3);
+  assert(code == FERR_OK);
+  args = hay_flags_result_args(res, &n);
+  assert(args == nullptr && n == 0);
+
+  unlink(path);
+  hay_flags_result_destroy(res);
+  hay_flags_schema_destroy(schema);
+  hay_flags_destroy(port);
+  hay_flags_destroy(verbose);
+}
@@ -0,0 +1,136 @@
+#include <assert.h>
+#include <errno.h>
+#include <hay/flags.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+// Count every heap allocation the parse makes.
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+static size_t heap_allocs = 0;
+void *malloc(size_t size) {
+  heap_allocs++;
+  return __libc_malloc(size);
+}
+void *calloc(size_t n, size_t size) {
+  heap_allocs++;
+  return __libc_calloc(n, size);
+}
+#define HEAP_ALLOCS() heap_allocs
+#else
+#define HEAP_ALLOCS() (size_t)0
+#endif
+
+static bool inside(const char *p, const char *blob, size_t len) {
+  return p >= blob && p < blob + len;
+}
+
+static flag_t *fast;
+
+// Counts the blobs with --fast, and stops at the one with index 3.
+static int classify(flag_result_t *res, size_t i, void *ud) {
+  size_t *count = ud;
+  if (hay_flags_getbool(hay_flags_result_get(res, fast), false)) {
+    (*count)++;
+  }
+  return i == 3;
+}
+
+int main() {
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *host = hay_flags_create("host", 'H', FT_STR);
+  flag_t *tags = hay_flags_create("tag", 't', FT_STR_LIST);
+  flag_t *verbose = hay_flags_create("verbose", 'v', FT_COUNT);
+  fast = hay_flags_create("fast", 'f', FT_BOOL);
+  flag_t *flags[] = {port, host, tags, verbose, fast, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+  flag_result_t *res = hay_flags_result_create(schema);
+  assert(res != nullptr);
+
+  // The layout of /proc/<pid>/cmdline; values are views into the blob.
+  static const char blob[] = "agent\0--port\0" "80\0--host=example\0-t\0a\0"
+                             "-tb\0-vv\0op\0--\0-x";
+  size_t len = sizeof(blob) - 1; // The last NUL of the literal is kept.
+  flag_err_t code = hay_flags_parse_blob_r(res, blob, len);
+  assert(code == FERR_OK);
+  assert(hay_flags_getint(hay_flags_result_get(res, port), 0) == 80);
+  const char *h = hay_flags_getstr(hay_flags_result_get(res, host), "");
+  assert(strcmp(h, "example") == 0 && inside(h, blob, len));
+  size_t n = 0;
+  const flag_view_t *t =
+      hay_flags_getstrs(hay_flags_result_get(res, tags), &n);
+  assert(n == 2 && strcmp(t[0].ptr, "a") == 0 && strcmp(t[1].ptr, "b") == 0);
+  assert(inside(t[0].ptr, blob, len) && inside(t[1].ptr, blob, len));
+  assert(hay_flags_getcount(hay_flags_result_get(res, verbose), 0) == 2);
+  char *const *args = hay_flags_result_args(res, &n);
+  assert(n == 2 && strcmp(args[0], "op") == 0 && strcmp(args[1], "-x") == 0);
+  assert(inside(args[0], blob, len));
+
+  // Nothing is allocated once the arena of the result fits.
+  size_t before = HEAP_ALLOCS();
+  for (int i = 0; i < 100; i++) {
+    code = hay_flags_parse_blob_r(res, blob, len);
+    assert(code == FERR_OK);
+  }
+  assert(HEAP_ALLOCS() == before);
+
+  // A truncated last token is copied, terminated.
+  static const char cut[] = {'a', 0, '-', 'H', 0, 'e', 'x', 'a', 'm'};
+  code = hay_flags_parse_blob_r(res, cut, sizeof(cut));
+  assert(code == FERR_OK);
+  h = hay_flags_getstr(hay_flags_result_get(res, host), "");
+  assert(strcmp(h, "exam") == 0 && !inside(h, cut, sizeof(cut)));
+  static const char cut_bool[] = {'a', 0, '-', '-', 'f', 'a', 's', 't',
+                                  '=', 'f', 'a', 'l', 's', 'e'};
+  code = hay_flags_parse_blob_r(res, cut_bool, sizeof(cut_bool));
+  assert(code == FERR_OK);
+  assert(hay_flags_getbool(hay_flags_result_get(res, fast), true) == false);
+
+  // The program name is skipped, and errors index tokens.
+  code = hay_flags_parse_blob_r(res, "--port\0", 7);
+  assert(code == FERR_OK);
+  assert(hay_flags_result_get(res, port)->is_set == false);
+  code = hay_flags_parse_blob_r(res, "a\0-v\0--port\0x\0", 14);
+  assert(code == FERR_FORMAT);
+  assert(hay_flags_result_error(res)->arg == 3);
+  code = hay_flags_parse_blob_r(res, "a\0-v\0--port\0", 12);
+  assert(code == FERR_MISSING);
+  assert(hay_flags_result_error(res)->arg == 2);
+
+  // Empty blobs (kernel threads have one) and invalid arguments.
+  code = hay_flags_parse_blob_r(res, "", 0);
+  assert(code == FERR_OK);
+  code = hay_flags_parse_blob_r(res, nullptr, 0);
+  assert(code == FERR_OK);
+  flag_t *next = hay_flags_result_next(res, &(size_t){0});
+  assert(next == nullptr);
+  code = hay_flags_parse_blob_r(res, nullptr, 4);
+  assert(code == FERR_ARGS);
+  code = hay_flags_parse_blob_r(nullptr, blob, len);
+  assert(code == FERR_ARGS);
+
+  // A scan reuses one result for every blob.
+  flag_view_t blobs[] = {{"a\0--fast\0", 9}, {"b\0-p\0x\0", 7}, {"c\0", 2},
+                         {"d\0-vf\0", 6}, {"e\0-f\0", 5}};
+  size_t count = 0;
+  before = HEAP_ALLOCS();
+  long got = hay_flags_scan_blobs(res, blobs, 5, classify, &count);
+  assert(got == 1);
+  assert(count == 2);
+  assert(HEAP_ALLOCS() == before);
+  got = hay_flags_scan_blobs(res, blobs, 0, classify, &count);
+  assert(got == 0);
+  got = hay_flags_scan_blobs(res, nullptr, 1, classify, &count);
+  assert(got == -1);
+  assert(errno == EINVAL);
+  got = hay_flags_scan_blobs(res, blobs, 1, nullptr, nullptr);
+  assert(got == -1);
+
+  hay_flags_result_destroy(res);
+  hay_flags_schema_destroy(schema);
+  for (size_t i = 0; flags[i]; i++) {
+    hay_flags_destroy(flags[i]);
+  }
+}
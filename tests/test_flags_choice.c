@@ -0,0 +1,109 @@
+#include <assert.h>
+#include <errno.h>
+#include <hay/flags.h>
+#include <stdio.h>
+#include <string.h>
+
+enum { MODE_FAST, MODE_SAFE, MODE_DEBUG };
+
+int main() {
+  static const char *const modes[] = {"fast", "safe", "debug", nullptr};
+  flag_choices_t *choices = hay_flags_choices_create(modes);
+  assert(choices != nullptr);
+  assert(strcmp(hay_flags_choices_name(choices, MODE_DEBUG), "debug") == 0);
+  assert(hay_flags_choices_name(choices, 3) == nullptr);
+
+  flag_t *mode = hay_flags_create("mode", 'm', FT_CHOICE);
+  mode->choices = choices;
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *flags[] = {mode, port, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+
+  assert(hay_flags_getchoice(mode, MODE_FAST) == MODE_FAST);
+  char *argv[] = {"./test", "--mode", "safe"};
+  int rc = hay_flags_schema_parse(schema, 3, argv);
+  assert(rc == 0);
+  assert(hay_flags_getchoice(mode, MODE_FAST) == MODE_SAFE);
+  char *argv2[] = {"./test", "-m", "debug"};
+  rc = hay_flags_schema_parse(schema, 3, argv2);
+  assert(rc == 0);
+  assert(hay_flags_getchoice(mode, MODE_FAST) == MODE_DEBUG);
+  assert(hay_flags_getchoice(port, -1) == -1);
+
+  // Anything else is rejected, and the flag keeps its value.
+  char *bad[] = {"saf", "safer", "SAFE", ""};
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+    char *one[] = {"./test", "--mode", bad[i]};
+    rc = hay_flags_schema_parse(schema, 3, one);
+    assert(rc == -1);
+    assert(errno == EINVAL);
+  }
+  assert(hay_flags_getchoice(mode, MODE_FAST) == MODE_DEBUG);
+
+  // The reentrant API names the flag and the argument.
+  flag_result_t *res = hay_flags_result_create(schema);
+  char *argv3[] = {"./test", "--port", "80", "--mode", "turbo"};
+  flag_err_t code = hay_flags_parse_r(res, 5, argv3);
+  assert(code == FERR_CHOICE);
+  const flag_error_t *err = hay_flags_result_error(res);
+  assert(err->code == FERR_CHOICE && err->errnum == EINVAL);
+  assert(err->flag && strcmp(err->flag->name, "mode") == 0);
+  assert(err->arg == 4);
+  assert(strcmp(hay_flags_strerror(FERR_CHOICE), "invalid choice") == 0);
+  code = hay_flags_parse_r(res, 3, argv);
+  assert(code == FERR_OK);
+  assert(hay_flags_getchoice(hay_flags_result_get(res, mode), -1) ==
+         MODE_SAFE);
+  hay_flags_result_destroy(res);
+
+  // The help lists the choices, and an argv renders the name back.
+  flag_view_t help = hay_flags_help(schema);
+  assert(help.ptr && strstr(help.ptr, "--mode <fast|safe|debug>"));
+  flag_ctx_t *ctx = hay_flags_ctx_create(nullptr);
+  int argc = 0;
+  char **out = hay_flags_ctx_to_argv(ctx, schema, "app", &argc);
+  assert(out && argc == 2 && strcmp(out[1], "--mode=debug") == 0);
+  hay_flags_ctx_destroy(ctx);
+
+  // Invalid sets.
+  static const char *const dup[] = {"a", "b", "a", nullptr};
+  flag_choices_t *invalid = hay_flags_choices_create(dup);
+  assert(invalid == nullptr && errno == EEXIST);
+  static const char *const none[] = {nullptr};
+  invalid = hay_flags_choices_create(none);
+  assert(invalid == nullptr && errno == EINVAL);
+  invalid = hay_flags_choices_create(nullptr);
+  assert(invalid == nullptr && errno == EINVAL);
+
+  // The largest set gets a perfect hash too, and every name resolves to its
+  // own ID.
+  static char names[256][8];
+  const char *many[257];
+  for (int i = 0; i < 256; i++) {
+    snprintf(names[i], sizeof(names[i]), "c%d", i);
+    many[i] = names[i];
+  }
+  many[256] = nullptr;
+  invalid = hay_flags_choices_create(many);
+  assert(invalid == nullptr && errno == EINVAL);
+  many[255] = nullptr;
+  flag_choices_t *big = hay_flags_choices_create(many);
+  assert(big != nullptr);
+  mode->choices = big;
+  for (int i = 0; i < 255; i++) {
+    char *one[] = {"./test", "--mode", names[i]};
+    rc = hay_flags_schema_parse(schema, 3, one);
+    assert(rc == 0);
+    assert(hay_flags_getchoice(mode, -1) == i);
+  }
+  char *miss[] = {"./test", "--mode", "c255"};
+  rc = hay_flags_schema_parse(schema, 3, miss);
+  assert(rc == -1);
+
+  hay_flags_schema_destroy(schema);
+  hay_flags_destroy(mode);
+  hay_flags_destroy(port);
+  hay_flags_choices_destroy(choices);
+  hay_flags_choices_destroy(big);
+}
@@ -0,0 +1,141 @@
+#include <assert.h>
+#include <errno.h>
+#include <hay/flags.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int built[3];
+static flag_t *own[3];
+
+// Builds the flags of a command; ud is its number.
+static flag_schema_t *build(flag_ctx_t *ctx, void *ud) {
+  int which = *(int *)ud;
+  built[which]++;
+  own[which] = hay_flags_ctx_create_flag(ctx, which == 0 ? "depth" : "fetch",
+                                         'd', which == 0 ? FT_INT : FT_BOOL);
+  flag_t *flags[] = {own[which], nullptr};
+  return hay_flags_ctx_schema(ctx, flags);
+}
+
+static int ids[3] = {0, 1, 2};
+static size_t blocks;
+
+// Counts the blocks the context of the tree draws.
+static void *count_alloc(void *ud, size_t size) {
+  (void)ud;
+  blocks++;
+  return malloc(size);
+}
+
+static void count_free(void *ud, void *ptr) {
+  (void)ud;
+  free(ptr);
+}
+
+static const flag_cmd_t remote_cmds[] = {
+    {.name = "add", .build = build, .ud = &ids[1]},
+    {.name = "show"},
+    {0},
+};
+
+static const flag_cmd_t cmds[] = {
+    {.name = "clone", .build = build, .ud = &ids[0]},
+    {.name = "remote", .subs = remote_cmds},
+    {.name = "status", .build = build, .ud = &ids[2]},
+    {0},
+};
+
+// A command nested in itself, as deep as the command line goes.
+static const flag_cmd_t nest[] = {
+    {.name = "in", .subs = nest},
+    {0},
+};
+
+int main() {
+  flag_t *verbose = hay_flags_create("verbose", 'v', FT_COUNT);
+  flag_t *name = hay_flags_create("name", 'n', FT_STR);
+  flag_t *gflags[] = {verbose, name, nullptr};
+  flag_schema_t *globals = hay_flags_schema_create(gflags);
+
+  flag_allocator_t alloc = {count_alloc, count_free, nullptr};
+  flag_ctx_t *ctx = hay_flags_ctx_create(&alloc);
+  flag_cmds_t *tree = hay_flags_cmds_create(ctx, globals, cmds);
+  assert(tree != nullptr);
+
+  // Only the selected command is built; global flags work on either side.
+  const flag_cmd_t *sel;
+  char *argv[] = {"./git", "-v", "clone", "--depth", "3", "-v", "url"};
+  int rc = hay_flags_cmds_parse(tree, 7, argv, &sel);
+  assert(rc == 0);
+  assert(sel == &cmds[0]);
+  assert(built[0] == 1 && built[1] == 0 && built[2] == 0);
+  assert(hay_flags_getcount(verbose, 0) == 2);
+
+  // Nested commands, and a second selection reuses the built schema.
+  char *argv2[] = {"./git", "remote", "add", "-d", "origin"};
+  rc = hay_flags_cmds_parse(tree, 5, argv2, &sel);
+  assert(rc == 0);
+  assert(sel == &remote_cmds[0]);
+  assert(built[1] == 1);
+  rc = hay_flags_cmds_parse(tree, 5, argv2, &sel);
+  assert(rc == 0);
+  assert(built[1] == 1);
+
+  // Commands without flags of their own.
+  char *argv3[] = {"./git", "remote", "show", "-v"};
+  rc = hay_flags_cmds_parse(tree, 4, argv3, &sel);
+  assert(rc == 0);
+  assert(sel == &remote_cmds[1]);
+
+  // Only the first operand of a level names a command.
+  char *argv4[] = {"./git", "file", "status"};
+  rc = hay_flags_cmds_parse(tree, 3, argv4, &sel);
+  assert(rc == 0);
+  assert(sel == nullptr);
+  assert(built[2] == 0);
+
+  // Flags of another command are not accepted.
+  flag_t *depth = own[0];
+  char *argv5[] = {"./git", "status", "--depth", "3"};
+  rc = hay_flags_cmds_parse(tree, 4, argv5, &sel);
+  assert(rc == 0);
+  assert(sel == &cmds[2]);
+  assert(!depth->is_set && hay_flags_getint(depth, -1) == -1);
+
+  // A parse unsets what the previous one set, and reuses its memory.
+  char *argv6[] = {"./git", "--name", "a-long-enough-value", "clone", "-d",
+                   "1"};
+  char *argv7[] = {"./git", "-v", "status"};
+  size_t before = 0;
+  for (int round = 0; round < 1000; round++) {
+    rc = hay_flags_cmds_parse(tree, 6, argv6, &sel);
+    assert(rc == 0);
+    const char *value = hay_flags_getstr(name, "");
+    assert(strcmp(value, argv6[2]) == 0 && value != argv6[2]);
+    assert(hay_flags_getint(depth, 0) == 1);
+    rc = hay_flags_cmds_parse(tree, 3, argv7, &sel);
+    assert(rc == 0);
+    assert(!name->is_set && !depth->is_set);
+    unsigned count = hay_flags_getcount(verbose, 0);
+    assert(count == 1);
+    if (round == 0) {
+      before = blocks;
+    }
+  }
+  assert(blocks == before);
+
+  // Too deep a descent has an error of its own, apart from response files.
+  flag_cmds_t *deep = hay_flags_cmds_create(ctx, nullptr, nest);
+  assert(deep != nullptr);
+  char *argv8[] = {"./t", "in", "in", "in", "in", "in",
+                   "in",  "in", "in", "in", "in"};
+  rc = hay_flags_cmds_parse(deep, 11, argv8, &sel);
+  assert(rc == -1 && errno == ELOOP);
+  const char *msg = hay_flags_strerror(FERR_CMD_DEPTH);
+  assert(strcmp(msg, "commands nested too deeply") == 0);
+
+  hay_flags_ctx_destroy(ctx);
+  hay_flags_schema_destroy(globals);
+  hay_flags_destroy(verbose);
+  hay_flags_destroy(name);
+}
@@ -0,0 +1,72 @@
+#include <assert.h>
+#include <hay/flags.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int main() {
+  char path[] = "/tmp/hay_flags_config_XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  const char *contents = "# defaults\n"
+                         "port = 8080\n"
+                         "dir = \"/var/lib/app\"\n"
+                         "unknown = whatever\n"
+                         "\n"
+                         "; enable it\n"
+                         "verbose\n"
+                         "name=app";
+  ssize_t wrote = write(fd, contents, strlen(contents));
+  assert(wrote == (ssize_t)strlen(contents));
+  close(fd);
+
+  char *argv[] = {"./test", "--port", "3000"};
+  int argc = 3;
+
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *dir = hay_flags_create("dir", 'd', FT_STR);
+  flag_t *verbose = hay_flags_create("verbose", 'V', FT_BOOL);
+  flag_t *name = hay_flags_create("name", 'n', FT_STR);
+  flag_t *flags[] = {port, dir, verbose, name, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+
+  // argv overrides the file, even when the file is loaded afterwards.
+  int rc = hay_flags_schema_parse(schema, argc, argv);
+  assert(rc == 0);
+  rc = hay_flags_schema_load_config(schema, path);
+  assert(rc == 0);
+
+  assert(hay_flags_getint(port, 0) == 3000);
+  assert(port->src == FS_ARGV);
+  assert(strcmp(hay_flags_getstr(dir, ""), "/var/lib/app") == 0);
+  assert(dir->src == FS_CONFIG);
+  assert(hay_flags_getbool(verbose, false));
+  assert(strcmp(hay_flags_getstr(name, ""), "app") == 0);
+
+  // ... and when it is loaded first.
+  flag_t *port2 = hay_flags_create("port", 'p', FT_INT);
+  flag_t *flags2[] = {port2, nullptr};
+  flag_schema_t *schema2 = hay_flags_schema_create(flags2);
+  rc = hay_flags_schema_load_config(schema2, path);
+  assert(rc == 0);
+  assert(hay_flags_getint(port2, 0) == 8080);
+  rc = hay_flags_schema_parse(schema2, argc, argv);
+  assert(rc == 0);
+  assert(hay_flags_getint(port2, 0) == 3000);
+
+  // Borrowed values point into the mapping kept by the context.
+  flag_ctx_t *ctx = hay_flags_ctx_create(nullptr);
+  hay_flags_schema_set_opts(schema, FSO_BORROW);
+  rc = hay_flags_ctx_load_config(ctx, schema, path);
+  assert(rc == 0);
+  assert(strcmp(hay_flags_getstr(name, ""), "app") == 0);
+  hay_flags_ctx_destroy(ctx);
+
+  rc = hay_flags_schema_load_config(schema, "/nonexistent/hay");
+  assert(rc == -1);
+
+  unlink(path);
+  hay_flags_schema_destroy(schema);
+  hay_flags_schema_destroy(schema2);
+}
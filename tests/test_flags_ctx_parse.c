@@ -0,0 +1,86 @@
+#include <assert.h>
+#include <hay/flags.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t live = 0;
+
+static void *count_alloc(void *ud, size_t size) {
+  (void)ud;
+  live++;
+  return malloc(size);
+}
+
+static void count_free(void *ud, void *ptr) {
+  (void)ud;
+  live--;
+  free(ptr);
+}
+
+int main() {
+  char *argv[] = {"./test", "-V", "--port", "3000", "-d", "src", "-d", "lib"};
+  int argc = 8;
+
+  flag_allocator_t hooks = {count_alloc, count_free, nullptr};
+  flag_ctx_t *ctx = hay_flags_ctx_create(&hooks);
+  assert(ctx != nullptr);
+
+  flag_ctx_stats_t stats;
+  size_t warm = 0;
+
+  for (int round = 0; round < 16; round++) {
+    hay_flags_ctx_reset(ctx);
+
+    flag_t *port = hay_flags_ctx_create_flag(ctx, "port", 'p', FT_INT);
+    flag_t *dir = hay_flags_ctx_create_flag(ctx, "dir", 'd', FT_STR);
+    flag_t *verbose = hay_flags_ctx_create_flag(ctx, "verbose", 'V', FT_BOOL);
+    flag_t *flags[] = {port, dir, verbose, nullptr};
+
+    flag_schema_t *schema = hay_flags_ctx_schema(ctx, flags);
+    assert(schema != nullptr);
+
+    int res = hay_flags_ctx_parse(ctx, schema, argc, argv);
+    assert(res == 0);
+    assert(hay_flags_getint(port, 0) == 3000);
+    assert(strcmp(hay_flags_getstr(dir, "./"), "lib") == 0);
+    assert(hay_flags_getbool(verbose, false) == true);
+
+    // Arena values are released with the context, never individually.
+    hay_flags_schema_destroy(schema);
+    hay_flags_destroy(dir);
+
+    hay_flags_ctx_stats(ctx, &stats);
+    if (round == 0) {
+      warm = stats.allocs;
+    }
+    // Once warm, the steady state does not touch the heap at all.
+    assert(stats.allocs == warm);
+  }
+
+  hay_flags_ctx_destroy(ctx);
+  assert(live == 0);
+
+  // A flag of a context parsed without one owns heap copies, which
+  // hay_flags_destroy() frees while leaving the flag to the context.
+  ctx = hay_flags_ctx_create(&hooks);
+  flag_t *name = hay_flags_ctx_create_flag(ctx, "dir", 'd', FT_STR);
+  flag_t *inc = hay_flags_ctx_create_flag(ctx, "inc", 'I', FT_STR_LIST);
+  flag_t *heap_flags[] = {name, inc, nullptr};
+  char *heap_argv[] = {"./test", "-d", "src", "-I", "a", "-I", "b"};
+  int heap_res = hay_flags_parse(heap_flags, 7, heap_argv);
+  assert(heap_res == 0);
+  assert(strcmp(hay_flags_getstr(name, ""), "src") == 0);
+  hay_flags_destroy(name);
+  hay_flags_destroy(inc);
+  assert(hay_flags_getstr(name, nullptr) == nullptr);
+  hay_flags_ctx_destroy(ctx);
+  assert(live == 0);
+
+  // Heap flags release the copies the parser made.
+  flag_t *dir = hay_flags_create("dir", 'd', FT_STR);
+  flag_t *flags[] = {dir, nullptr};
+  int rc = hay_flags_parse(flags, argc, argv);
+  assert(rc == 0);
+  assert(strcmp(hay_flags_getstr(dir, "./"), "lib") == 0);
+  hay_flags_destroy(dir);
+}
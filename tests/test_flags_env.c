@@ -0,0 +1,103 @@
+#include <assert.h>
+#include <errno.h>
+#include <hay/flags.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main() {
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *level = hay_flags_create("log-level", 'l', FT_STR);
+  flag_t *verbose = hay_flags_create("verbose", 'V', FT_BOOL);
+  flag_t *home = hay_flags_create("home", 0, FT_STR);
+  flag_t *tags = hay_flags_create("tag", 't', FT_STR_LIST);
+  home->env = "APP_HOME_DIR";
+  flag_t *flags[] = {port, level, verbose, home, tags, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+
+  char *envp[] = {
+      "PATH=/usr/bin",
+      "MYAPP_PORT=8080",
+      "MYAPP_LOG_LEVEL=debug",
+      "MYAPP_VERBOSE=1",
+      "MYAPP_HOME=/ignored", // home is only bound to APP_HOME_DIR.
+      "APP_HOME_DIR=/srv/app",
+      "MYAPP_UNKNOWN=whatever",
+      "MYAPP_=empty",
+      "MYAPP_TAG=a",
+      nullptr,
+  };
+  int rc = hay_flags_schema_load_env(schema, "MYAPP_", envp);
+  assert(rc == 0);
+  assert(hay_flags_getint(port, 0) == 8080);
+  assert(port->src == FS_ENV);
+  assert(strcmp(hay_flags_getstr(level, ""), "debug") == 0);
+  assert(hay_flags_getbool(verbose, false));
+  assert(strcmp(hay_flags_getstr(home, ""), "/srv/app") == 0);
+  assert(home->src == FS_ENV);
+  assert(tags->val.val_list.len == 1);
+
+  // argv overrides the environment, even when it is loaded afterwards.
+  char *argv[] = {"./test", "--port", "3000", "--tag", "b"};
+  rc = hay_flags_schema_parse(schema, 5, argv);
+  assert(rc == 0);
+  rc = hay_flags_schema_load_env(schema, "MYAPP_", envp);
+  assert(rc == 0);
+  assert(hay_flags_getint(port, 0) == 3000);
+  assert(port->src == FS_ARGV);
+  assert(tags->val.val_list.len == 1);
+  assert(strcmp(((flag_view_t *)tags->val.val_list.items)[0].ptr, "b") == 0);
+
+  // The environment overrides a config file, and a config file does not
+  // override the environment.
+  flag_t *port2 = hay_flags_create("port", 'p', FT_INT);
+  flag_t *flags2[] = {port2, nullptr};
+  flag_schema_t *schema2 = hay_flags_schema_create(flags2);
+  port2->val.val_int = 1;
+  port2->is_set = true;
+  port2->src = FS_CONFIG;
+  rc = hay_flags_schema_load_env(schema2, "MYAPP_", envp);
+  assert(rc == 0);
+  assert(hay_flags_getint(port2, 0) == 8080);
+  assert(port2->src == FS_ENV);
+
+  // Without a prefix, only explicit bindings are used.
+  flag_t *port3 = hay_flags_create("port", 'p', FT_INT);
+  flag_t *flags3[] = {port3, nullptr};
+  flag_schema_t *schema3 = hay_flags_schema_create(flags3);
+  rc = hay_flags_schema_load_env(schema3, nullptr, envp);
+  assert(rc == 0);
+  assert(!port3->is_set);
+
+  // A bad value is reported like a bad argument.
+  char *bad[] = {"MYAPP_PORT=80x", nullptr};
+  rc = hay_flags_schema_load_env(schema3, "MYAPP_", bad);
+  assert(rc == -1);
+  assert(errno == EINVAL);
+  assert(!port3->is_set);
+
+  // nullptr reads the process environment.
+  rc = setenv("HAY_TEST_PORT", "4242", 1);
+  assert(rc == 0);
+  rc = hay_flags_schema_load_env(schema3, "HAY_TEST_", nullptr);
+  assert(rc == 0);
+  assert(hay_flags_getint(port3, 0) == 4242);
+
+  // Two flags cannot share a variable.
+  port3->env = "PORT";
+  flag_t *other = hay_flags_create("other", 0, FT_INT);
+  other->env = "PORT";
+  flag_t *flags4[] = {port3, other, nullptr};
+  flag_schema_t *schema4 = hay_flags_schema_create(flags4);
+  rc = hay_flags_schema_load_env(schema4, nullptr, envp);
+  assert(rc == -1);
+  assert(errno == EEXIST);
+
+  rc = hay_flags_schema_load_env(nullptr, "MYAPP_", envp);
+  assert(rc == -1);
+
+  hay_flags_schema_destroy(schema);
+  hay_flags_schema_destroy(schema2);
+  hay_flags_schema_destroy(schema3);
+  hay_flags_schema_destroy(schema4);
+}
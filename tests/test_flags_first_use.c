@@ -0,0 +1,50 @@
+#include <assert.h>
+#include <hay/flags.h>
+#include <pthread.h>
+#include <string.h>
+
+#define THREADS 8
+
+#define APP_FLAGS(X, T)                                                        \
+  X(T, port, 'p', FT_INT)                                                      \
+  X(T, prefix, 0, FT_STR)                                                      \
+  X(T, verbose, 'v', FT_BOOL)
+
+HAY_FLAGS_STATIC(app_flags, APP_FLAGS);
+
+static pthread_barrier_t start;
+
+// Every thread makes its first use of the schema at once: the hash index,
+// the sorted index and the help are each built by one of them.
+static void *first_use(void *arg) {
+  int *ok = arg;
+  pthread_barrier_wait(&start);
+  flag_result_t *res = hay_flags_result_create(&app_flags);
+  char *argv[] = {"./test", "--po", "80", "--verb"};
+  flag_err_t err = res ? hay_flags_parse_r(res, 4, argv) : FERR_NOMEM;
+  flag_t *port = res ? hay_flags_result_get(res, HAY_FLAGS_GET(app_flags, port))
+                     : nullptr;
+  const flag_t *out[2];
+  long n = hay_flags_complete(&app_flags, "--p", out, 2);
+  flag_view_t help = hay_flags_help(&app_flags);
+  *ok = err == FERR_OK && hay_flags_getint(port, 0) == 80 && n == 2 &&
+        help.ptr && strstr(help.ptr, "--prefix");
+  hay_flags_result_destroy(res);
+  return nullptr;
+}
+
+int main() {
+  hay_flags_schema_set_opts(&app_flags, FSO_ABBREV);
+  int ok[THREADS];
+  pthread_t threads[THREADS];
+  pthread_barrier_init(&start, nullptr, THREADS);
+  for (int i = 0; i < THREADS; i++) {
+    int rc = pthread_create(&threads[i], nullptr, first_use, &ok[i]);
+    assert(rc == 0);
+  }
+  for (int i = 0; i < THREADS; i++) {
+    pthread_join(threads[i], nullptr);
+    assert(ok[i]);
+  }
+  pthread_barrier_destroy(&start);
+}
@@ -17,7 +17,7 @@ int main() {
 
   const char *d = hay_flags_getstr(dir, "./");
 
-  assert(strcmp(d, "./") == true);
+  assert(strcmp(d, "./") == 0);
 
   flag_t *flags[] = {port, dir, repl, verbose, enable, nullptr};
 
@@ -0,0 +1,45 @@
+#include <assert.h>
+#include <hay/flags.h>
+#include <string.h>
+
+int main() {
+  char *argv[] = {"./test", "-d", "src", "--name", "hay", "--out", "bin"};
+  int argc = 7;
+
+  flag_t *dir = hay_flags_create("dir", 'd', FT_STR);
+  flag_t *name = hay_flags_create("name", 'n', FT_STR);
+  flag_t *out = hay_flags_create("out", 'o', FT_STR);
+  dir->opts |= FO_BORROW;
+
+  flag_view_t none = {"./", 2};
+  flag_view_t v = hay_flags_getview(dir, none);
+  assert(v.ptr == none.ptr && v.len == 2);
+
+  flag_t *flags[] = {dir, name, out, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+
+  int rc = hay_flags_schema_parse(schema, argc, argv);
+  assert(rc == 0);
+
+  // Borrowed values point straight into argv.
+  v = hay_flags_getview(dir, none);
+  assert(v.ptr == argv[2] && v.len == 3);
+  assert(hay_flags_getstr(dir, "./") == argv[2]);
+
+  // Without borrowing, values are copies.
+  v = hay_flags_getview(name, none);
+  assert(v.ptr != argv[4] && v.len == 3 && strcmp(v.ptr, "hay") == 0);
+
+  // The schema option borrows for every flag.
+  hay_flags_schema_set_opts(schema, FSO_BORROW);
+  rc = hay_flags_schema_parse(schema, argc, argv);
+  assert(rc == 0);
+  assert(hay_flags_getstr(name, "") == argv[4]);
+  assert(hay_flags_getstr(out, "") == argv[6]);
+
+  hay_flags_schema_destroy(schema);
+  hay_flags_destroy(dir);
+  hay_flags_destroy(name);
+  hay_flags_destroy(out);
+}
@@ -0,0 +1,52 @@
+#include <assert.h>
+#include <hay/flags.h>
+#include <string.h>
+#include <unistd.h>
+
+int main() {
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *inc = hay_flags_create("include", 0, FT_STR_LIST);
+  flag_t *verbose = hay_flags_create("verbose", 'v', FT_COUNT);
+  flag_t *wide = hay_flags_create("a-very-long-option-name", 0, FT_DURATION);
+  hay_flags_describe(port, "Port to listen on", "8080");
+  hay_flags_describe(inc, "Add a search directory", nullptr);
+  hay_flags_describe(wide, nullptr, "1s");
+
+  flag_t *flags[] = {port, inc, verbose, wide, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+
+  const char *expected =
+      "  -p, --port <int>        Port to listen on (default: 8080)\n"
+      "      --include <str>...  Add a search directory\n"
+      "  -v, --verbose\n"
+      "      --a-very-long-option-name <duration>\n"
+      "                          (default: 1s)\n";
+  flag_view_t help = hay_flags_help(schema);
+  assert(help.len == strlen(expected));
+  assert(memcmp(help.ptr, expected, help.len) == 0);
+
+  // The text is rendered once and cached.
+  flag_view_t cached = hay_flags_help(schema);
+  assert(cached.ptr == help.ptr);
+
+  int fds[2];
+  int rc = pipe(fds);
+  assert(rc == 0);
+  rc = hay_flags_print_help(schema, fds[1], "Usage: app [options]\n");
+  assert(rc == 0);
+  close(fds[1]);
+  char buf[512];
+  size_t got = 0;
+  for (ssize_t r; (r = read(fds[0], buf + got, sizeof(buf) - got)) > 0;) {
+    got += (size_t)r;
+  }
+  close(fds[0]);
+  assert(got == 21 + help.len);
+  assert(memcmp(buf, "Usage: app [options]\n", 21) == 0);
+  assert(memcmp(buf + 21, expected, help.len) == 0);
+
+  hay_flags_schema_destroy(schema);
+  for (size_t i = 0; flags[i]; i++) {
+    hay_flags_destroy(flags[i]);
+  }
+}
@@ -0,0 +1,64 @@
+#define HAY_FLAGS_INLINE
+#include <assert.h>
+#include <hay/flags.h>
+#include <string.h>
+
+int main() {
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *host = hay_flags_create("host", 'H', FT_STR);
+  flag_t *fast = hay_flags_create("fast", 'f', FT_BOOL);
+  flag_t *size = hay_flags_create("size", 's', FT_SIZE);
+  flag_t *tags = hay_flags_create("tag", 't', FT_STR_LIST);
+  flag_t *verbose = hay_flags_create("verbose", 'v', FT_COUNT);
+  flag_t *flags[] = {port, host, fast, size, tags, verbose, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+
+  // Unset flags, wrong types and nullptr all give the default.
+  int p = hay_flags_getint(port, 8080);
+  assert(p == 8080);
+  const char *h = hay_flags_getstr(host, "localhost");
+  assert(strcmp(h, "localhost") == 0);
+  bool f = hay_flags_getbool(fast, true);
+  assert(f == true);
+  p = hay_flags_getint(nullptr, -1);
+  assert(p == -1);
+
+  char *argv[] = {"./test", "-p", "80",    "--host", "example", "--fast",
+                  "-s",     "4k", "-t",    "a",      "-t",      "b",
+                  "-vv"};
+  int rc = hay_flags_schema_parse(schema, 13, argv);
+  assert(rc == 0);
+  p = hay_flags_getint(port, 8080);
+  assert(p == 80);
+  h = hay_flags_getstr(host, "");
+  assert(strcmp(h, "example") == 0);
+  flag_view_t v = hay_flags_getview(host, (flag_view_t){0});
+  assert(v.len == 7);
+  f = hay_flags_getbool(fast, false);
+  assert(f == true);
+  uint64_t s = hay_flags_getsize(size, 0);
+  assert(s == 4096);
+  unsigned c = hay_flags_getcount(verbose, 0);
+  assert(c == 2);
+  p = hay_flags_getint(host, -1);
+  assert(p == -1);
+  h = hay_flags_getstr(port, nullptr);
+  assert(h == nullptr);
+
+  size_t n = 9;
+  const flag_view_t *t = hay_flags_getstrs(tags, &n);
+  assert(n == 2 && strcmp(t[1].ptr, "b") == 0);
+  const int64_t *ints = hay_flags_getints(tags, &n);
+  assert(ints == nullptr && n == 0);
+
+  // The inline getters are functions like the exported ones.
+  int (*getint)(flag_t *, const int) = hay_flags_getint;
+  p = getint(port, 0);
+  assert(p == 80);
+
+  hay_flags_schema_destroy(schema);
+  for (size_t i = 0; flags[i]; i++) {
+    hay_flags_destroy(flags[i]);
+  }
+}
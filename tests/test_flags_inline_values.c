@@ -0,0 +1,50 @@
+#include <assert.h>
+#include <hay/flags.h>
+#include <string.h>
+
+int main() {
+  char *argv[] = {"./test", "--port=3000", "-dsrc", "-Vn2", "--name=",
+                  "--quiet=false", "-Vv", "x", "--eq=a=b"};
+  int argc = 9;
+
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *dir = hay_flags_create("dir", 'd', FT_STR);
+  flag_t *num = hay_flags_create("num", 'n', FT_INT_LIST);
+  flag_t *name = hay_flags_create("name", 0, FT_STR);
+  flag_t *quiet = hay_flags_create("quiet", 'q', FT_BOOL);
+  flag_t *verbose = hay_flags_create("verbose", 'V', FT_COUNT);
+  flag_t *value = hay_flags_create("value", 'v', FT_STR);
+  flag_t *eq = hay_flags_create("eq", 0, FT_STR);
+  flag_t *flags[] = {port, dir, num, name, quiet, verbose, value, eq, nullptr};
+  int rc = hay_flags_parse(flags, argc, argv);
+  assert(rc == 0);
+
+  assert(hay_flags_getint(port, 0) == 3000);
+  assert(strcmp(hay_flags_getstr(dir, ""), "src") == 0);
+  size_t n;
+  const int64_t *nums = hay_flags_getints(num, &n);
+  assert(n == 1 && nums[0] == 2);
+  assert(name->is_set && strcmp(hay_flags_getstr(name, "x"), "") == 0);
+  assert(quiet->is_set && hay_flags_getbool(quiet, true) == false);
+  assert(hay_flags_getcount(verbose, 0) == 2);
+  // A value flag at the end of a bundle takes the next token.
+  assert(strcmp(hay_flags_getstr(value, ""), "x") == 0);
+  // Only the first '=' splits.
+  assert(strcmp(hay_flags_getstr(eq, ""), "a=b") == 0);
+
+  // A name is matched on its whole length, not as a prefix.
+  char *argv2[] = {"./test", "--port3000", "--portx=1", "--po=1"};
+  flag_t *flags2[] = {port, nullptr};
+  rc = hay_flags_parse(flags2, 4, argv2);
+  assert(rc == 0);
+  assert(hay_flags_getint(port, 0) == 3000);
+
+  // Values attached to a short name are checked like any other.
+  char *argv3[] = {"./test", "-p30x"};
+  rc = hay_flags_parse(flags2, 2, argv3);
+  assert(rc == -1);
+
+  for (size_t i = 0; flags[i]; i++) {
+    hay_flags_destroy(flags[i]);
+  }
+}
@@ -0,0 +1,99 @@
+#include <assert.h>
+#include <hay/flags.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MANY 20000
+
+int main() {
+  char *argv[] = {"./test", "-I", "a", "--include", "b", "-vvv", "-n", "1",
+                  "-n",     "-2", "-I", "c",        "-v"};
+  int argc = 13;
+
+  flag_t *inc = hay_flags_create("include", 'I', FT_STR_LIST);
+  flag_t *num = hay_flags_create("num", 'n', FT_INT_LIST);
+  flag_t *verbose = hay_flags_create("verbose", 'v', FT_COUNT);
+  flag_t *flags[] = {inc, num, verbose, nullptr};
+  int rc = hay_flags_parse(flags, argc, argv);
+  assert(rc == 0);
+
+  size_t n;
+  const flag_view_t *strs = hay_flags_getstrs(inc, &n);
+  assert(n == 3);
+  assert(strcmp(strs[0].ptr, "a") == 0 && strs[0].len == 1);
+  assert(strcmp(strs[1].ptr, "b") == 0);
+  assert(strcmp(strs[2].ptr, "c") == 0);
+  assert(strs[2].ptr != argv[11]); // Copied, not borrowed.
+
+  const int64_t *ints = hay_flags_getints(num, &n);
+  assert(n == 2 && ints[0] == 1 && ints[1] == -2);
+  assert(hay_flags_getcount(verbose, 0) == 4);
+
+  // Wrong type or unset.
+  ints = hay_flags_getints(inc, &n);
+  assert(ints == nullptr && n == 0);
+  flag_t *unset = hay_flags_create("unset", 0, FT_STR_LIST);
+  strs = hay_flags_getstrs(unset, &n);
+  assert(strs == nullptr && n == 0);
+  assert(hay_flags_getcount(unset, 7) == 7);
+
+  // A bad item is reported and skipped.
+  char *bad[] = {"./test", "-n", "3", "-n", "x"};
+  flag_t *num2 = hay_flags_create("num", 'n', FT_INT_LIST);
+  flag_t *flags2[] = {num2, nullptr};
+  rc = hay_flags_parse(flags2, 5, bad);
+  assert(rc == -1);
+  ints = hay_flags_getints(num2, &n);
+  assert(n == 1 && ints[0] == 3);
+
+  // A parse repeated with the same schema does not add to the last one.
+  char *again[] = {"./test", "-I", "a", "-vv"};
+  flag_schema_t *repeat = hay_flags_schema_create(flags);
+  assert(repeat != nullptr);
+  for (int round = 0; round < 3; round++) {
+    rc = hay_flags_schema_parse(repeat, 4, again);
+    assert(rc == 0);
+    strs = hay_flags_getstrs(inc, &n);
+    assert(n == 1 && strcmp(strs[0].ptr, "a") == 0);
+    unsigned count = hay_flags_getcount(verbose, 0);
+    assert(count == 2);
+  }
+  hay_flags_schema_destroy(repeat);
+
+  // Many items, through a context and through a result.
+  static char *big[1 + 2 * MANY];
+  static char names[MANY][8];
+  big[0] = "./test";
+  for (int i = 0; i < MANY; i++) {
+    snprintf(names[i], sizeof(names[i]), "p%d", i);
+    big[1 + 2 * i] = "-I";
+    big[2 + 2 * i] = names[i];
+  }
+
+  flag_ctx_t *ctx = hay_flags_ctx_create(nullptr);
+  flag_t *paths = hay_flags_ctx_create_flag(ctx, "include", 'I', FT_STR_LIST);
+  flag_t *flags3[] = {paths, nullptr};
+  flag_schema_t *schema = hay_flags_ctx_schema(ctx, flags3);
+  rc = hay_flags_ctx_parse(ctx, schema, 1 + 2 * MANY, big);
+  assert(rc == 0);
+  strs = hay_flags_getstrs(paths, &n);
+  assert(n == MANY);
+  assert(strcmp(strs[MANY - 1].ptr, names[MANY - 1]) == 0);
+
+  flag_result_t *res = hay_flags_result_create(schema);
+  for (int round = 0; round < 2; round++) {
+    flag_err_t code = hay_flags_parse_r(res, 1 + 2 * MANY, big);
+    assert(code == FERR_OK);
+    strs = hay_flags_getstrs(hay_flags_result_get(res, paths), &n);
+    assert(n == MANY); // A new parse starts a new list.
+    assert(strcmp(strs[1234].ptr, "p1234") == 0);
+  }
+  hay_flags_result_destroy(res);
+  hay_flags_ctx_destroy(ctx);
+
+  hay_flags_destroy(inc);
+  hay_flags_destroy(num);
+  hay_flags_destroy(verbose);
+  hay_flags_destroy(unset);
+  hay_flags_destroy(num2);
+}
@@ -0,0 +1,116 @@
+#include <assert.h>
+#include <hay/flags.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define READERS 4
+#define RELOADS 2000
+
+static flag_t *port, *host, *tags;
+static flag_live_t *live;
+static atomic_bool done;
+
+// Every version the writer publishes has host "h<port>" and port tags, all
+// "t<port>": a reader seeing anything else saw a torn version.
+static void *reader(void *arg) {
+  (void)arg;
+  flag_reader_t *r = hay_flags_live_reader(live);
+  assert(r != nullptr);
+  uint64_t last = 0;
+  long reads = 0;
+  while (!atomic_load(&done) || reads < 1000) {
+    uint64_t gen = hay_flags_live_enter(r);
+    assert(gen >= last);
+    last = gen;
+    int p = hay_flags_getint(hay_flags_live_get(r, port), -1);
+    const char *h = hay_flags_getstr(hay_flags_live_get(r, host), "");
+    size_t n;
+    const flag_view_t *t = hay_flags_getstrs(hay_flags_live_get(r, tags), &n);
+    char want[32];
+    snprintf(want, sizeof(want), "h%d", p);
+    assert(strcmp(h, want) == 0);
+    assert(n == (size_t)p % 4 + 1);
+    want[0] = 't';
+    for (size_t i = 0; i < n; i++) {
+      assert(strcmp(t[i].ptr, want) == 0);
+    }
+    hay_flags_live_exit(r);
+    reads++;
+  }
+  hay_flags_live_reader_release(r);
+  return nullptr;
+}
+
+int main() {
+  port = hay_flags_create("port", 'p', FT_INT);
+  host = hay_flags_create("host", 'H', FT_STR);
+  tags = hay_flags_create("tag", 't', FT_STR_LIST);
+  flag_t *flags[] = {port, host, tags, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+
+  char *argv[] = {"./test", "--port", "0", "--host", "h0", "--tag", "t0"};
+  int rc = hay_flags_schema_parse(schema, 7, argv);
+  assert(rc == 0);
+  live = hay_flags_live_create(schema);
+  assert(live != nullptr);
+
+  // A version does not follow the flags until it is replaced.
+  flag_reader_t *r = hay_flags_live_reader(live);
+  uint64_t gen = hay_flags_live_enter(r);
+  assert(gen == 0);
+  char *d[] = {"--host", "elsewhere"};
+  long got = hay_flags_schema_apply(schema, 2, d);
+  assert(got == 1);
+  const char *pinned = hay_flags_getstr(hay_flags_live_get(r, host), "");
+  assert(strcmp(pinned, "h0") == 0);
+  hay_flags_live_exit(r);
+  char *back[] = {"--host", "h0"};
+  got = hay_flags_schema_apply(schema, 2, back);
+  assert(got == 1);
+  rc = hay_flags_live_publish(live);
+  assert(rc == 0);
+  gen = hay_flags_live_enter(r);
+  assert(gen == hay_flags_schema_gen(schema));
+  hay_flags_live_exit(r);
+  hay_flags_live_reader_release(r);
+
+  pthread_t threads[READERS];
+  for (int i = 0; i < READERS; i++) {
+    rc = pthread_create(&threads[i], nullptr, reader, nullptr);
+    assert(rc == 0);
+  }
+  for (int i = 1; i <= RELOADS; i++) {
+    char p[16], h[16], t[16];
+    snprintf(p, sizeof(p), "%d", i);
+    snprintf(h, sizeof(h), "h%d", i);
+    snprintf(t, sizeof(t), "t%d", i);
+    char *delta[] = {"--port", p, "--host", h,
+                     "--tag",  t, "--tag",  t, "--tag", t, "--tag", t};
+    got = hay_flags_schema_apply(schema, 4 + 2 * (i % 4 + 1), delta);
+    assert(got == 3);
+    rc = hay_flags_live_publish(live);
+    assert(rc == 0);
+  }
+  atomic_store(&done, true);
+  for (int i = 0; i < READERS; i++) {
+    pthread_join(threads[i], nullptr);
+  }
+
+  // Released slots are reused.
+  flag_reader_t *a = hay_flags_live_reader(live);
+  flag_reader_t *b = hay_flags_live_reader(live);
+  assert(a && b && a != b);
+  hay_flags_live_reader_release(a);
+  flag_reader_t *again = hay_flags_live_reader(live);
+  assert(again == a);
+
+  hay_flags_live_destroy(live);
+  hay_flags_schema_destroy(schema);
+  for (size_t i = 0; flags[i]; i++) {
+    hay_flags_destroy(flags[i]);
+  }
+}
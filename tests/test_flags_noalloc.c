@@ -0,0 +1,76 @@
+#include <assert.h>
+#include <hay/flags.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+// Count every heap allocation the parse makes.
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+static size_t heap_allocs = 0;
+void *malloc(size_t size) {
+  heap_allocs++;
+  return __libc_malloc(size);
+}
+void *calloc(size_t n, size_t size) {
+  heap_allocs++;
+  return __libc_calloc(n, size);
+}
+#define HEAP_ALLOCS() heap_allocs
+#else
+#define HEAP_ALLOCS() (size_t)0
+#endif
+
+// A bump allocator over static storage; free() is a no-op.
+static alignas(max_align_t) unsigned char pool[1 << 16];
+static size_t pool_used = 0;
+static void *pool_alloc(void *ud, size_t size) {
+  (void)ud;
+  size = (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+  if (size > sizeof(pool) - pool_used) {
+    return nullptr;
+  }
+  pool_used += size;
+  return pool + pool_used - size;
+}
+static void pool_free(void *ud, void *ptr) {
+  (void)ud;
+  (void)ptr;
+}
+
+#define APP_FLAGS(X, T)                                                        \
+  X(T, port, 'p', FT_INT)                                                      \
+  X(T, root, 'r', FT_STR)                                                      \
+  X(T, ratio, 0, FT_DOUBLE)                                                    \
+  X(T, include, 'I', FT_STR_LIST)                                              \
+  X(T, verbose, 'v', FT_COUNT)
+
+HAY_FLAGS_STATIC(app_flags, APP_FLAGS);
+
+int main() {
+  char *argv[] = {"./test", "-p", "80", "--root=/srv", "--ratio", "0.25",
+                  "-Ia",    "-Ib", "-vv"};
+  flag_allocator_t hooks = {pool_alloc, pool_free, nullptr};
+  flag_ctx_t *ctx = hay_flags_ctx_create(&hooks);
+  assert(ctx != nullptr);
+
+  // A static schema parsed through a context over caller memory never
+  // touches the heap.
+  size_t before = HEAP_ALLOCS();
+  int rc = hay_flags_ctx_parse(ctx, &app_flags, 9, argv);
+  assert(rc == 0);
+  assert(HEAP_ALLOCS() == before);
+
+  assert(hay_flags_getint(HAY_FLAGS_GET(app_flags, port), 0) == 80);
+  assert(strcmp(hay_flags_getstr(HAY_FLAGS_GET(app_flags, root), ""), "/srv") ==
+         0);
+  assert(hay_flags_getdouble(HAY_FLAGS_GET(app_flags, ratio), 0) == 0.25);
+  size_t n;
+  const flag_view_t *inc = hay_flags_getstrs(HAY_FLAGS_GET(app_flags, include),
+                                             &n);
+  assert(n == 2 && strcmp(inc[1].ptr, "b") == 0);
+  assert(hay_flags_getcount(HAY_FLAGS_GET(app_flags, verbose), 0) == 2);
+  assert(pool_used > 0);
+  hay_flags_ctx_destroy(ctx);
+}
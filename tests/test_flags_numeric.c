@@ -0,0 +1,90 @@
+#include <assert.h>
+#include <errno.h>
+#include <float.h>
+#include <hay/flags.h>
+#include <stdint.h>
+
+int main() {
+  char *argv[] = {"./test",     "--port",  "3000",     "--offset",
+                  "-9223372036854775808",  "--count",  "0xffffffffffffffff",
+                  "--ratio",    "0.25",    "--buffer", "64M",
+                  "--timeout",  "1h30m250ms"};
+  int argc = 13;
+
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *offset = hay_flags_create("offset", 0, FT_INT64);
+  flag_t *count = hay_flags_create("count", 0, FT_UINT64);
+  flag_t *ratio = hay_flags_create("ratio", 0, FT_DOUBLE);
+  flag_t *buffer = hay_flags_create("buffer", 0, FT_SIZE);
+  flag_t *timeout = hay_flags_create("timeout", 0, FT_DURATION);
+  flag_t *flags[] = {port, offset, count, ratio, buffer, timeout, nullptr};
+
+  int rc = hay_flags_parse(flags, argc, argv);
+  assert(rc == 0);
+  assert(hay_flags_getint(port, 0) == 3000);
+  assert(hay_flags_getint64(offset, 0) == INT64_MIN);
+  assert(hay_flags_getuint64(count, 0) == UINT64_MAX);
+  assert(hay_flags_getdouble(ratio, 0) == 0.25);
+  assert(hay_flags_getsize(buffer, 0) == 64ull << 20);
+  assert(hay_flags_getduration(timeout, 0) ==
+         (90 * 60 + 0) * 1000000000ll + 250000000ll);
+
+  // Trailing junk is a format error; the flag keeps its value.
+  char *junk[] = {"./test", "--port", "12abc"};
+  errno = 0;
+  rc = hay_flags_parse(flags, 3, junk);
+  assert(rc == -1);
+  assert(errno == EINVAL);
+  assert(hay_flags_getint(port, 0) == 3000);
+
+  // Only the 64-bit types take hexadecimal.
+  char *hex[] = {"./test", "--offset", "-0x10", "--port", "0x50"};
+  errno = 0;
+  rc = hay_flags_parse(flags, 5, hex);
+  assert(rc == -1);
+  assert(errno == EINVAL);
+  assert(hay_flags_getint64(offset, 0) == -16);
+  assert(hay_flags_getint(port, 0) == 3000);
+
+  // Values that do not fit are range errors, not silent truncation.
+  char *big[] = {"./test", "--port", "4294967296", "--buffer", "32E"};
+  rc = hay_flags_parse(flags, 5, big);
+  assert(rc == -1);
+  assert(errno == ERANGE);
+  assert(hay_flags_getint(port, 0) == 3000);
+  assert(hay_flags_getsize(buffer, 0) == 64ull << 20);
+
+  char *units[] = {"./test", "--timeout", "10", "--buffer", "4KiB"};
+  rc = hay_flags_parse(flags, 5, units);
+  assert(rc == 0);
+  assert(hay_flags_getduration(timeout, 0) == 10000000000ll);
+  assert(hay_flags_getsize(buffer, 0) == 4096);
+
+  // Subnormal values are kept, and only underflow to zero is a range error.
+  char *tiny[] = {"./test", "--ratio", "4.9e-324"};
+  rc = hay_flags_parse(flags, 3, tiny);
+  assert(rc == 0);
+  assert(hay_flags_getdouble(ratio, 0) == DBL_TRUE_MIN);
+  tiny[2] = "1e-310";
+  rc = hay_flags_parse(flags, 3, tiny);
+  assert(rc == 0);
+  double v = hay_flags_getdouble(ratio, 0);
+  assert(v > 0.99e-310 && v < 1.01e-310);
+  tiny[2] = "0e-400";
+  rc = hay_flags_parse(flags, 3, tiny);
+  assert(rc == 0 && hay_flags_getdouble(ratio, 1) == 0);
+  tiny[2] = "-1e-400";
+  errno = 0;
+  rc = hay_flags_parse(flags, 3, tiny);
+  assert(rc == -1 && errno == ERANGE);
+  assert(hay_flags_getdouble(ratio, 1) == 0);
+
+  char *bad[] = {"./test", "--timeout", "5parsecs"};
+  rc = hay_flags_parse(flags, 3, bad);
+  assert(rc == -1);
+  assert(errno == EINVAL);
+
+  for (int i = 0; flags[i]; i++) {
+    hay_flags_destroy(flags[i]);
+  }
+}
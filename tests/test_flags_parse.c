@@ -11,7 +11,7 @@ int main() {
   flag_t *repl = hay_flags_create("repl", 'r', FT_NULL);
   flag_t *verbose = hay_flags_create("verbose", 'V', FT_NULL);
 
-  flag_t *flags[] = {port, dir, repl, verbose};
+  flag_t *flags[] = {port, dir, repl, verbose, nullptr};
   int res = hay_flags_parse(flags, argc, argv);
 
   assert(errno == 0);
@@ -0,0 +1,69 @@
+#include <assert.h>
+#include <hay/flags.h>
+#include <stdio.h>
+#include <string.h>
+
+#define N 200
+
+#define APP_FLAGS(X, T)                                                        \
+  X(T, port, 'p', FT_INT)                                                      \
+  X(T, dir, 'd', FT_STR)                                                       \
+  X(T, verbose, 0, FT_BOOL)
+
+HAY_FLAGS_STATIC(app_flags, APP_FLAGS);
+
+int main() {
+  // The names of a static schema form one pool, in declaration order.
+  const char *port = HAY_FLAGS_GET(app_flags, port)->name;
+  assert(HAY_FLAGS_GET(app_flags, dir)->name == port + sizeof("port"));
+  assert(HAY_FLAGS_GET(app_flags, verbose)->name ==
+         port + sizeof("port") + sizeof("dir"));
+  char *argv[] = {"./test", "--verbose", "--dir=x"};
+  int rc = hay_flags_schema_parse(&app_flags, 3, argv);
+  assert(rc == 0);
+  assert(HAY_FLAGS_GET(app_flags, verbose)->is_set);
+
+  // Built schemas copy the names into a pool of their own.
+  static char names[N][8];
+  flag_t *flags[N + 1];
+  for (int i = 0; i < N; i++) {
+    snprintf(names[i], sizeof(names[i]), "f%d", i);
+    flags[i] = hay_flags_create(names[i], 0, FT_INT);
+  }
+  flags[N] = nullptr;
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+
+  // Only the flags a parse set are listed, across bitset words.
+  flag_result_t *res = hay_flags_result_create(schema);
+  char *argv2[] = {"./test", "--f3", "1", "--f64", "2", "--f199", "3"};
+  flag_err_t code = hay_flags_parse_r(res, 7, argv2);
+  assert(code == FERR_OK);
+  size_t pos = 0;
+  flag_t *f = hay_flags_result_next(res, &pos);
+  assert(f && strcmp(f->name, "f3") == 0 && hay_flags_getint(f, 0) == 1);
+  f = hay_flags_result_next(res, &pos);
+  assert(f && strcmp(f->name, "f64") == 0);
+  f = hay_flags_result_next(res, &pos);
+  assert(f && strcmp(f->name, "f199") == 0);
+  f = hay_flags_result_next(res, &pos);
+  assert(f == nullptr);
+
+  // The next parse clears them.
+  char *argv3[] = {"./test", "--f63", "4"};
+  code = hay_flags_parse_r(res, 3, argv3);
+  assert(code == FERR_OK);
+  pos = 0;
+  f = hay_flags_result_next(res, &pos);
+  assert(f && strcmp(f->name, "f63") == 0 && pos == 64);
+  f = hay_flags_result_next(res, &pos);
+  assert(f == nullptr);
+  assert(!hay_flags_result_get(res, flags[3])->is_set);
+  assert(hay_flags_getint(hay_flags_result_get(res, flags[199]), -1) == -1);
+
+  hay_flags_result_destroy(res);
+  hay_flags_schema_destroy(schema);
+  for (int i = 0; i < N; i++) {
+    hay_flags_destroy(flags[i]);
+  }
+}
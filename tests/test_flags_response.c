@@ -0,0 +1,89 @@
+#include <assert.h>
+#include <errno.h>
+#include <hay/flags.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void write_file(char *path, const char *contents) {
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  ssize_t wrote = write(fd, contents, strlen(contents));
+  assert(wrote == (ssize_t)strlen(contents));
+  close(fd);
+}
+
+int main() {
+  char inner[] = "/tmp/hay_flags_inner_XXXXXX";
+  write_file(inner, "--port 3000\n-V");
+
+  char outer[64] = "/tmp/hay_flags_outer_XXXXXX";
+  char body[128];
+  write_file(outer, "");
+  snprintf(body, sizeof(body),
+           "--name 'two words' --msg \"say \\\"hi\\\"\" @%s --dir", inner);
+  FILE *f = fopen(outer, "w");
+  fputs(body, f);
+  fclose(f);
+
+  char at[80];
+  snprintf(at, sizeof(at), "@%s", outer);
+  char *argv[] = {"./test", at, "src"};
+  int argc = 3;
+
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *dir = hay_flags_create("dir", 'd', FT_STR);
+  flag_t *name = hay_flags_create("name", 'n', FT_STR);
+  flag_t *msg = hay_flags_create("msg", 'm', FT_STR);
+  flag_t *verbose = hay_flags_create("verbose", 'V', FT_BOOL);
+  flag_t *flags[] = {port, dir, name, msg, verbose, nullptr};
+
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+
+  // Without the option, "@file" is an operand.
+  int rc = hay_flags_schema_parse(schema, argc, argv);
+  assert(rc == 0);
+  assert(!port->is_set);
+
+  hay_flags_schema_set_opts(schema, FSO_RESPONSE_FILES | FSO_BORROW);
+  rc = hay_flags_schema_parse(schema, argc, argv);
+  assert(rc == 0);
+  assert(hay_flags_getint(port, 0) == 3000);
+  assert(hay_flags_getbool(verbose, false));
+  assert(strcmp(hay_flags_getstr(name, ""), "two words") == 0);
+  assert(strcmp(hay_flags_getstr(msg, ""), "say \"hi\"") == 0);
+  // A flag at the end of a file takes its value from argv.
+  assert(hay_flags_getstr(dir, "") == argv[2]);
+
+  // With a context, borrowed values point into the kept mapping.
+  flag_ctx_t *ctx = hay_flags_ctx_create(nullptr);
+  rc = hay_flags_ctx_parse(ctx, schema, argc, argv);
+  assert(rc == 0);
+  assert(strcmp(hay_flags_getstr(name, ""), "two words") == 0);
+  hay_flags_ctx_destroy(ctx);
+
+  // A file including itself stops at the depth limit.
+  char loop[] = "/tmp/hay_flags_loop_XXXXXX";
+  write_file(loop, "");
+  f = fopen(loop, "w");
+  fprintf(f, "@%s", loop);
+  fclose(f);
+  snprintf(at, sizeof(at), "@%s", loop);
+  errno = 0;
+  rc = hay_flags_schema_parse(schema, 2, argv);
+  assert(rc == -1);
+  assert(errno == ELOOP);
+
+  // A missing file is reported.
+  char *missing[] = {"./test", "@/nonexistent/hay_flags"};
+  rc = hay_flags_schema_parse(schema, 2, missing);
+  assert(rc == -1);
+  assert(errno == ENOENT);
+
+  unlink(inner);
+  unlink(outer);
+  unlink(loop);
+  hay_flags_schema_destroy(schema);
+}
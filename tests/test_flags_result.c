@@ -0,0 +1,97 @@
+#include <assert.h>
+#include <errno.h>
+#include <hay/flags.h>
+#include <stdio.h>
+#include <string.h>
+
+#define N 256
+
+int main() {
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *dir = hay_flags_create("dir", 'd', FT_STR);
+  flag_t *verbose = hay_flags_create("verbose", 'V', FT_BOOL);
+  flag_t *flags[] = {port, dir, verbose, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+
+  // Parsing into a result leaves the flags of the schema untouched.
+  char *argv[] = {"./test", "-V", "--port", "3000", "-d", "src"};
+  flag_result_t *res = hay_flags_result_create(schema);
+  assert(res != nullptr);
+  flag_err_t code = hay_flags_parse_r(res, 6, argv);
+  assert(code == FERR_OK);
+  assert(hay_flags_getint(hay_flags_result_get(res, port), 0) == 3000);
+  assert(strcmp(hay_flags_getstr(hay_flags_result_get(res, dir), ""), "src") ==
+         0);
+  assert(hay_flags_getbool(hay_flags_result_get(res, verbose), false));
+  assert(!port->is_set && !dir->is_set && !verbose->is_set);
+
+  // Each parse starts from a clean result.
+  char *argv2[] = {"./test", "--port", "12x"};
+  code = hay_flags_parse_r(res, 3, argv2);
+  assert(code == FERR_FORMAT);
+  const flag_error_t *err = hay_flags_result_error(res);
+  assert(err->arg == 2);
+  assert(strcmp(err->flag->name, "port") == 0);
+  assert(!hay_flags_result_get(res, verbose)->is_set);
+  assert(!hay_flags_result_get(res, port)->is_set);
+
+  char *argv3[] = {"./test", "-V", "-p"};
+  code = hay_flags_parse_r(res, 3, argv3);
+  assert(code == FERR_MISSING);
+  assert(hay_flags_result_error(res)->arg == 2);
+  assert(strcmp(hay_flags_strerror(FERR_MISSING), "missing value") == 0);
+  hay_flags_result_destroy(res);
+
+  // A batch parses many vectors against one schema on several threads.
+  static char ports[N][8];
+  static char *vectors[N][4];
+  flag_argv_t inputs[N];
+  flag_result_t *results[N];
+  for (int i = 0; i < N; i++) {
+    snprintf(ports[i], sizeof(ports[i]), "%d", i);
+    vectors[i][0] = "./test";
+    vectors[i][1] = "-p";
+    vectors[i][2] = i % 16 == 15 ? "bad" : ports[i];
+    vectors[i][3] = "--verbose";
+    inputs[i] = (flag_argv_t){4, vectors[i]};
+    results[i] = hay_flags_result_create(schema);
+    assert(results[i] != nullptr);
+  }
+
+  long got = hay_flags_parse_batch(results, inputs, N, 4);
+  assert(got == N / 16);
+  for (int i = 0; i < N; i++) {
+    flag_t *p = hay_flags_result_get(results[i], port);
+    if (i % 16 == 15) {
+      assert(hay_flags_result_error(results[i])->code == FERR_FORMAT);
+      assert(!p->is_set);
+    } else {
+      assert(hay_flags_result_error(results[i])->code == FERR_OK);
+      assert(hay_flags_getint(p, -1) == i);
+    }
+    assert(hay_flags_getbool(hay_flags_result_get(results[i], verbose), false));
+  }
+
+  // A pool keeps its workers from one batch to the next.
+  flag_pool_t *pool = hay_flags_pool_create(4);
+  assert(pool != nullptr);
+  for (int round = 0; round < 50; round++) {
+    got = hay_flags_pool_parse(pool, results, inputs, N);
+    assert(got == N / 16);
+    assert(hay_flags_getint(hay_flags_result_get(results[7], port), -1) == 7);
+  }
+  got = hay_flags_pool_parse(pool, results, inputs, 0);
+  assert(got == 0);
+  got = hay_flags_pool_parse(nullptr, results, inputs, N);
+  assert(got == -1 && errno == EINVAL);
+  hay_flags_pool_destroy(pool);
+  for (int i = 0; i < N; i++) {
+    hay_flags_result_destroy(results[i]);
+  }
+
+  hay_flags_schema_destroy(schema);
+  for (int i = 0; flags[i]; i++) {
+    hay_flags_destroy(flags[i]);
+  }
+}
@@ -0,0 +1,43 @@
+#include <assert.h>
+#include <errno.h>
+#include <hay/flags.h>
+#include <string.h>
+
+int main() {
+  char *argv[] = {"./test", "-Vr", "--port", "3000", "-d", "src", "file"};
+  int argc = 7;
+
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *dir = hay_flags_create("dir", 'd', FT_STR);
+  flag_t *repl = hay_flags_create("repl", 'r', FT_BOOL);
+  flag_t *verbose = hay_flags_create("verbose", 'V', FT_BOOL);
+
+  flag_t *flags[] = {port, dir, repl, verbose, nullptr};
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  assert(schema != nullptr);
+
+  // The same schema can be reused for several parses.
+  for (int round = 0; round < 2; round++) {
+    int res = hay_flags_schema_parse(schema, argc, argv);
+    assert(res == 0);
+    assert(hay_flags_getint(port, 0) == 3000);
+    assert(strcmp(hay_flags_getstr(dir, "./"), "src") == 0);
+    assert(hay_flags_getbool(repl, false) == true);
+    assert(hay_flags_getbool(verbose, false) == true);
+  }
+
+  hay_flags_schema_destroy(schema);
+
+  // Duplicated names are rejected.
+  flag_t *again = hay_flags_create("port", 'P', FT_INT);
+  flag_t *dups[] = {port, again, nullptr};
+  flag_schema_t *bad = hay_flags_schema_create(dups);
+  assert(bad == nullptr);
+  assert(errno == EEXIST);
+
+  flag_t *clash = hay_flags_create("other", 'p', FT_INT);
+  flag_t *shorts[] = {port, clash, nullptr};
+  bad = hay_flags_schema_create(shorts);
+  assert(bad == nullptr);
+  assert(errno == EEXIST);
+}
@@ -0,0 +1,130 @@
+#include <assert.h>
+#include <errno.h>
+#include <hay/flags.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const char *names[] = {"port", "root", "ratio", "include", "num",
+                              "verbose", "quiet", "timeout", nullptr};
+static const flag_ty_t types[] = {FT_INT,  FT_STR,   FT_DOUBLE, FT_STR_LIST,
+                                  FT_INT_LIST, FT_COUNT, FT_BOOL, FT_DURATION};
+
+// One flag set per process in the real use; three here.
+static flag_schema_t *make(flag_t **flags) {
+  for (int i = 0; names[i]; i++) {
+    flags[i] = hay_flags_create(names[i], 0, types[i]);
+  }
+  flags[8] = nullptr;
+  return hay_flags_schema_create(flags);
+}
+
+static void check(flag_t **f) {
+  size_t n;
+  assert(hay_flags_getint(f[0], 0) == -8080);
+  assert(strcmp(hay_flags_getstr(f[1], ""), "/srv/a b") == 0);
+  assert(hay_flags_getdouble(f[2], 0) == 0.1);
+  const flag_view_t *inc = hay_flags_getstrs(f[3], &n);
+  assert(n == 2 && strcmp(inc[0].ptr, "x") == 0 && inc[1].len == 3);
+  const int64_t *nums = hay_flags_getints(f[4], &n);
+  assert(n == 3 && nums[0] == INT64_MIN && nums[2] == 7);
+  assert(hay_flags_getcount(f[5], 0) == 3);
+  assert(hay_flags_getbool(f[6], true) == false);
+  assert(hay_flags_getduration(f[7], 0) == 1500000000);
+}
+
+int main() {
+  char *argv[] = {"./test",    "--port=-8080", "--root",     "/srv/a b",
+                  "--ratio",   "0.1",          "--include=x", "--include=y=z",
+                  "--num",     "-9223372036854775808",          "--num=0",
+                  "--num=7",   "--verbose",    "--verbose",  "--verbose",
+                  "--quiet=0", "--timeout=1s500ms"};
+  int argc = 17;
+  flag_t *src[9];
+  flag_schema_t *schema = make(src);
+  int rc = hay_flags_schema_parse(schema, argc, argv);
+  assert(rc == 0);
+  check(src);
+
+  size_t len;
+  void *blob = hay_flags_snapshot(schema, &len);
+  assert(blob != nullptr);
+
+  // The child maps the blob and reads the values straight from it.
+  char path[] = "/tmp/hay_flags_snapshot_XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  ssize_t wrote = write(fd, blob, len);
+  assert(wrote == (ssize_t)len);
+  void *map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  assert(map != MAP_FAILED);
+  flag_t *dst[9];
+  flag_schema_t *child = make(dst);
+  rc = hay_flags_schema_load_snapshot(child, map, len);
+  assert(rc == 0);
+  check(dst);
+  assert(dst[1]->val.val_str > (char *)map &&
+         dst[1]->val.val_str < (char *)map + len);
+
+  // A later parse of a list writes to fresh items, never to the mapping.
+  char *more[] = {"./child", "--num", "2", "--include=w"};
+  rc = hay_flags_schema_parse(child, 4, more);
+  assert(rc == 0);
+  size_t items;
+  const int64_t *nums = hay_flags_getints(dst[4], &items);
+  assert(items == 1 && nums[0] == 2);
+  const flag_view_t *inc = hay_flags_getstrs(dst[3], &items);
+  assert(items == 1 && strcmp(inc[0].ptr, "w") == 0);
+
+  // Or re-execs with a minimal argv.
+  flag_ctx_t *ctx = hay_flags_ctx_create(nullptr);
+  int n;
+  char **args = hay_flags_ctx_to_argv(ctx, schema, "./child", &n);
+  flag_t *re[9];
+  flag_schema_t *again = make(re);
+  if (args) {
+    assert(n == 12 && args[n] == nullptr);
+    assert(strcmp(args[0], "./child") == 0);
+    assert(strcmp(args[1], "--port=-8080") == 0);
+    assert(strcmp(args[7], "--num=0") == 0);
+    assert(strcmp(args[10], "--quiet=false") == 0);
+    rc = hay_flags_schema_parse(again, n, args);
+    assert(rc == 0);
+    check(re);
+  } else {
+    assert(errno == ENOTSUP); // A minimal build cannot format --ratio.
+  }
+
+  // Malformed or mismatched snapshots are rejected before anything changes.
+  unsigned char *bad = malloc(len);
+  memcpy(bad, blob, len);
+  bad[0] = 'X';
+  rc = hay_flags_schema_load_snapshot(child, bad, len);
+  assert(rc == -1 && errno == EINVAL);
+  rc = hay_flags_schema_load_snapshot(child, blob, len - 8);
+  assert(rc == -1);
+  flag_t *port = hay_flags_create("port", 0, FT_STR);
+  flag_t *other[] = {port, nullptr};
+  flag_schema_t *mismatch = hay_flags_schema_create(other);
+  rc = hay_flags_schema_load_snapshot(mismatch, blob, len);
+  assert(rc == -1 && errno == EINVAL);
+  assert(!port->is_set);
+
+  free(bad);
+  hay_flags_schema_destroy(mismatch);
+  hay_flags_destroy(port);
+  hay_flags_ctx_destroy(ctx);
+  flag_t **sets[] = {src, dst, re};
+  flag_schema_t *schemas[] = {schema, child, again};
+  for (int s = 0; s < 3; s++) {
+    hay_flags_schema_destroy(schemas[s]);
+    for (int i = 0; sets[s][i]; i++) {
+      hay_flags_destroy(sets[s][i]);
+    }
+  }
+  munmap(map, len);
+  close(fd);
+  unlink(path);
+  free(blob);
+}
@@ -0,0 +1,30 @@
+#include <assert.h>
+#include <hay/flags.h>
+#include <string.h>
+
+#define APP_FLAGS(X, T)                                                        \
+  X(T, port, 'p', FT_INT)                                                      \
+  X(T, dir, 'd', FT_STR)                                                       \
+  X(T, repl, 'r', FT_BOOL)                                                     \
+  X(T, verbose, 0, FT_BOOL)                                                    \
+  X(T, quiet, 0, FT_BOOL)
+
+HAY_FLAGS_STATIC(app_flags, APP_FLAGS);
+
+int main() {
+  char *argv[] = {"./test", "-r", "--port", "3000", "-d", "src", "--verbose"};
+  int argc = 7;
+
+  assert(hay_flags_getint(HAY_FLAGS_GET(app_flags, port), 8080) == 8080);
+
+  for (int round = 0; round < 2; round++) {
+    int rc = hay_flags_schema_parse(&app_flags, argc, argv);
+    assert(rc == 0);
+    assert(hay_flags_getint(HAY_FLAGS_GET(app_flags, port), 8080) == 3000);
+    assert(strcmp(hay_flags_getstr(HAY_FLAGS_GET(app_flags, dir), "./"),
+                  "src") == 0);
+    assert(hay_flags_getbool(HAY_FLAGS_GET(app_flags, repl), false));
+    assert(hay_flags_getbool(HAY_FLAGS_GET(app_flags, verbose), false));
+    assert(!hay_flags_getbool(HAY_FLAGS_GET(app_flags, quiet), false));
+  }
+}
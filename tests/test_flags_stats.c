@@ -0,0 +1,64 @@
+#include <assert.h>
+#include <errno.h>
+#include <hay/flags.h>
+#include <string.h>
+
+static flag_stats_t last;
+static int calls;
+
+static void hook(const flag_schema_t *schema, const flag_stats_t *stats,
+                 void *ud) {
+  assert(schema != nullptr);
+  assert(ud == &calls);
+  last = *stats;
+  calls++;
+}
+
+int main() {
+  if (hay_flags_set_stats_hook(hook, &calls) != 0) {
+    assert(errno == ENOTSUP); // Built with -DSTATS_flags=OFF.
+    return 0;
+  }
+
+  char *argv[] = {"./test", "--port", "x1", "-qd", "src", "--nope", "file",
+                  "-p"};
+  int argc = 8;
+
+  flag_t *port = hay_flags_create("port", 'p', FT_INT);
+  flag_t *dir = hay_flags_create("dir", 'd', FT_STR);
+  flag_t *flags[] = {port, dir, nullptr};
+  int rc = hay_flags_parse(flags, argc, argv);
+  assert(rc == -1);
+
+  assert(calls == 1);
+  assert(last.tokens == 7);
+  assert(last.long_matches == 1);
+  assert(last.short_matches == 2);
+  assert(last.unknown == 2); // -q and --nope.
+  assert(last.conv_failures == 1);
+  assert(last.missing == 1);
+  assert(last.allocs == 1); // The copy of "src".
+  assert(last.ns_total >= last.ns_index);
+
+  // Every parse reports, through results too.
+  flag_schema_t *schema = hay_flags_schema_create(flags);
+  flag_result_t *res = hay_flags_result_create(schema);
+  char *ok[] = {"./test", "-p", "80"};
+  flag_err_t code = hay_flags_parse_r(res, 3, ok);
+  assert(code == FERR_OK);
+  assert(calls == 2);
+  assert(last.tokens == 2 && last.short_matches == 1 && last.unknown == 0);
+  assert(last.conv_failures == 0 && last.missing == 0);
+
+  // Removing the hook stops the reports.
+  rc = hay_flags_set_stats_hook(nullptr, nullptr);
+  assert(rc == 0);
+  code = hay_flags_parse_r(res, 3, ok);
+  assert(code == FERR_OK);
+  assert(calls == 2);
+
+  hay_flags_result_destroy(res);
+  hay_flags_schema_destroy(schema);
+  hay_flags_destroy(port);
+  hay_flags_destroy(dir);
+}